@@ -0,0 +1,261 @@
+#!/usr/bin/env bash
+# Builds the programs in this directory with the given compiler and prints the fastest of RUNS (default 3)
+# runs of every variant.
+# usage : benchmarks/run.sh <compiler> [benchmark...], without names every benchmark is run
+
+set -euo pipefail
+
+if [ $# -lt 1 ]; then
+    echo "usage : $0 <compiler> [benchmark...]" >&2
+    exit 1
+fi
+compiler=$(realpath "$1")
+shift
+sources=$(cd "$(dirname "$0")" && pwd)
+runs=${RUNS:-3}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# compile <output> <source> [options...] : builds an executable into the work directory
+compile(){
+    local output=$1 source=$2
+    shift 2
+    "$compiler" "$source" "$work/$output" "$@" > /dev/null
+}
+
+# buildAndRun <output> <source> [options...] : compile, then start the executable
+buildAndRun(){
+    compile "$@"
+    "$work/$1"
+}
+
+# measure <label> <command...> : prints the fastest wall time of the command, its output is discarded
+measure(){
+    local label=$1
+    shift
+    local best=""
+    for ((run = 0; run < runs; run++)); do
+        local start
+        start=$(date +%s%N)
+        "$@" > /dev/null
+        local elapsed=$((($(date +%s%N) - start) / 1000000))
+        if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then
+            best=$elapsed
+        fi
+    done
+    printf '  %-48s %8d ms\n' "$label" "$best"
+}
+
+# phases <label> <directory> <source> [options...] : prints the phase timings of one compilation in directory,
+# imports are found relative to it
+phases(){
+    local label=$1 directory=$2 source=$3
+    shift 3
+    echo "  $label"
+    (cd "$directory" && "$compiler" "$source" "$work/phases.out" --time "$@") 2>&1 | sed 's/^/    /'
+}
+
+# generatePackages <directory> <packages> <functions> : writes main.src importing packages of functions each
+generatePackages(){
+    local directory=$1 packages=$2 functions=$3
+    mkdir -p "$directory"
+    {
+        for ((package = 0; package < packages; package++)); do
+            echo "import \"p$package\""
+        done
+        echo "func int main(){"
+        echo "    int total = 0;"
+        for ((package = 0; package < packages; package++)); do
+            echo "    total = total + p${package}f0($package);"
+        done
+        echo "    printlnInt(total);"
+        echo "    return 0;"
+        echo "}"
+    } > "$directory/main.src"
+    for ((package = 0; package < packages; package++)); do
+        for ((function = 0; function < functions; function++)); do
+            cat <<EOF
+func int p${package}f${function}(int x){
+    int i = 0;
+    int acc = x;
+    while(i < 10 && acc < 100000){
+        if(acc > 50){
+            acc = acc - $((function + 1));
+        }else{
+            acc = acc * 2 + $package;
+        }
+        i = i + 1;
+    }
+    return acc;
+}
+EOF
+        done > "$directory/p$package"
+    done
+}
+
+# generateFunctions <file> <functions> : writes a single file of functions that main cannot fold away
+generateFunctions(){
+    local file=$1 functions=$2
+    for ((function = 0; function < functions; function++)); do
+        cat <<EOF
+func int f${function}(int a, int b){
+    int c = a * ${function} + b;
+    while(c > 100){
+        c = c - 7;
+    }
+    return c;
+}
+
+EOF
+    done > "$file"
+    cat >> "$file" <<EOF
+func int main(){
+    printlnInt(f1(getNextInt(), 2));
+    return 0;
+}
+EOF
+}
+
+# the same program at every optimization level
+optimization_levels(){
+    for level in -O0 -O1 -O2 -O3; do
+        compile "primes$level" "$sources/primes.src" "$level"
+        measure "primes $level" "$work/primes$level"
+    done
+}
+
+# jit compiling a small program in-process against building an executable and starting it
+jit_latency(){
+    measure "fib_small --run" "$compiler" --run "$sources/fib_small.src"
+    measure "fib_small compile, link and run" buildAndRun fib_small "$sources/fib_small.src"
+}
+
+# 200 imported files of 30 functions each, parsed, analyzed and lowered on 1 and 4 threads.
+# -O0 --emit=bc leaves out the optimizer and the backend, which run once for the linked module
+parallel_frontend(){
+    generatePackages "$work/packages" 200 30
+    for jobs in 1 4; do
+        phases "200 packages -j$jobs" "$work/packages" main.src -O0 --emit=bc -j$jobs
+    done
+}
+
+# one module of 6000 functions, split into partitions that are code generated on 1 and 4 threads
+split_codegen(){
+    generateFunctions "$work/functions.src" 6000
+    for jobs in 1 4; do
+        phases "6000 functions -O1 -j$jobs" "$work" functions.src -O1 -j$jobs
+    done
+}
+
+# printing through the standard library archive against linking its bitcode into the program.
+# --lto needs the stdlinux.bc built with clang, STDLIB_BC can point to another one
+stdlib_lto(){
+    local bitcode=()
+    if [ -n "${STDLIB_BC:-}" ]; then
+        bitcode=(--stdlib-bc="$STDLIB_BC")
+    fi
+    compile print_ints "$sources/print_ints.src" -O2
+    measure "print_ints -O2" "$work/print_ints"
+    if ! compile print_ints_lto "$sources/print_ints.src" -O2 --lto "${bitcode[@]}" 2> /dev/null; then
+        echo "  no bitcode standard library, --lto skipped"
+        return
+    fi
+    measure "print_ints -O2 --lto" "$work/print_ints_lto"
+    compile print_ints_whole "$sources/print_ints.src" -O2 --lto --whole-program "${bitcode[@]}"
+    measure "print_ints -O2 --lto --whole-program" "$work/print_ints_whole"
+}
+
+# deep self recursion in tail position, and the same recursion with the call kept out of tail position
+tail_call(){
+    for level in -O0 -O1 -O2; do
+        compile "tail_call$level" "$sources/tail_call.src" "$level"
+        measure "tail_call $level" "$work/tail_call$level"
+        compile "tail_call_plain$level" "$sources/tail_call_plain.src" "$level"
+        measure "tail_call_plain $level" "$work/tail_call_plain$level"
+    done
+}
+
+# a branchy loop at -O2, without a profile and with the profile of a training run
+profile_guided(){
+    compile branches "$sources/branches.src" -O2
+    measure "branches -O2" "$work/branches"
+    compile branches_instrumented "$sources/branches.src" -O2 --profile-generate="$work/branches.profraw"
+    "$work/branches_instrumented" > /dev/null
+    compile branches_profiled "$sources/branches.src" -O2 --profile-use="$work/branches.profraw"
+    measure "branches -O2 --profile-use" "$work/branches_profiled"
+}
+
+# a reduction loop at -O3 for generic x86-64, the host cpu and skylake
+target_cpu(){
+    for cpu in "" -march=native -march=skylake; do
+        compile "reduction$cpu" "$sources/reduction.src" -O3 $cpu
+        measure "reduction -O3 $cpu" "$work/reduction$cpu"
+    done
+}
+
+# a dot product of int arrays against the same data held in int8 vectors
+vector_types(){
+    for options in -O0 -O1 -O2 "-O2 -march=native"; do
+        local name=${options// /}
+        compile "dot_int$name" "$sources/dot_int.src" $options
+        measure "dot_int $options" "$work/dot_int$name"
+        compile "dot_int8$name" "$sources/dot_int8.src" $options
+        measure "dot_int8 $options" "$work/dot_int8$name"
+    done
+}
+
+# a parallel loop of 20000 independent iterations on 1 thread, 4 threads and one per core
+parallel_loop(){
+    compile parallel_work "$sources/parallel_work.src" -O2
+    for threads in 1 4 "$(nproc)"; do
+        measure "parallel_work -O2 PARALLEL_THREADS=$threads" env PARALLEL_THREADS="$threads" "$work/parallel_work"
+    done
+}
+
+# naive recursive fib(40) with and without a memo table
+memo_functions(){
+    for level in -O0 -O2; do
+        compile "fib$level" "$sources/fib.src" "$level"
+        measure "fib $level" "$work/fib$level"
+        compile "fib_memo$level" "$sources/fib_memo.src" "$level"
+        measure "fib_memo $level" "$work/fib_memo$level"
+    done
+}
+
+# a 256 entry lookup table filled on every call against the same table as a const global
+constant_tables(){
+    for level in -O0 -O2; do
+        compile "bits_local$level" "$sources/bits_local.src" "$level"
+        measure "bits_local $level" "$work/bits_local$level"
+        compile "bits_global$level" "$sources/bits_global.src" "$level"
+        measure "bits_global $level" "$work/bits_global$level"
+    done
+}
+
+benchmarks=(
+    optimization_levels
+    jit_latency
+    parallel_frontend
+    split_codegen
+    stdlib_lto
+    tail_call
+    profile_guided
+    target_cpu
+    vector_types
+    parallel_loop
+    memo_functions
+    constant_tables
+)
+
+selected=("$@")
+if [ ${#selected[@]} -eq 0 ]; then
+    selected=("${benchmarks[@]}")
+fi
+for benchmark in "${selected[@]}"; do
+    if ! printf '%s\n' "${benchmarks[@]}" | grep -qx -- "$benchmark"; then
+        echo "unknown benchmark : $benchmark" >&2
+        exit 1
+    fi
+    echo "$benchmark"
+    "$benchmark"
+done
@@ -69,9 +69,21 @@ struct ConditionalStatement{
     ~ConditionalStatement();
 };
 
+// optional hints written after loop condition eg: while(i < n) unroll(4) vectorize { ... }
+struct LoopHints{
+    bool m_unroll = false;
+    uint32_t m_unrollCount = 0;
+    bool m_vectorize = false;
+    uint32_t m_vectorizeWidth = 0;
+    // iterations run on all cores, see Analyzer::analyzeParallelLoop for the accepted loops
+    bool m_parallel = false;
+    uint32_t m_parallelGrain = 0;
+};
+
 struct WhileLoop{
     Expression* m_expr;
     std::list<Statement*> m_stmnts;
+    LoopHints m_hints;
 
     WhileLoop(Expression* expr)
     : m_expr(expr) {
@@ -85,6 +97,7 @@ struct WhileLoop{
 struct Parameter{
     Token* m_dataType;
     Token* m_identifier;
+    uint32_t m_arraySize = 0; // 0 for scalars, arrays are passed by reference
 };
 
 struct FunctionCallStatement{
@@ -104,18 +117,20 @@ struct FunctionCallStatement{
 };
 
 struct ReturnStatement{
+    Token* m_keyword; // errors about the statement are reported here
     Expression* m_expr;
 
-    ReturnStatement(Expression* expr)
-        : m_expr(expr){
+    ReturnStatement(Token* keyword, Expression* expr)
+        : m_keyword(keyword), m_expr(expr){
     }
     
-    ReturnStatement()
-        : m_expr(nullptr){
+    ReturnStatement(Token* keyword)
+        : m_keyword(keyword), m_expr(nullptr){
 
     }
 
     ~ReturnStatement(){
+        delete m_keyword;
         delete m_expr;
     }
 };
@@ -123,14 +138,20 @@ struct ReturnStatement{
 struct AssignmentStatement{
     Token* m_identifier;
     Expression* m_expression;
+    Expression* m_index = nullptr; // set when an array element is assigned eg: a[i] = 5;
 
     AssignmentStatement(Token* identifier, Expression* expression)
         : m_identifier(identifier), m_expression(expression){
     }
 
+    AssignmentStatement(Token* identifier, Expression* index, Expression* expression)
+        : m_identifier(identifier), m_expression(expression), m_index(index){
+    }
+
     ~AssignmentStatement(){
         delete m_identifier;
         delete m_expression;
+        delete m_index;
     }
 
 };
@@ -142,7 +163,10 @@ struct DeclarativeStatement{
     Token* m_identifier;
     bool m_isConst;
     bool m_isInitialized;
+    bool m_isCompileTimeConstant = false; // set by analyzer when initializer of const is folded
+    uint32_t m_arraySize = 0; // 0 for scalars
     Expression* m_expression;
+    std::list<Expression*> m_elements; // {...} initializer of arrays, missing elements are zero
 
     DeclarativeStatement(Token* dataType, Token* identifier, bool isConst)
         : m_dataType(dataType), m_identifier(identifier), m_expression(nullptr), m_isConst(isConst), m_isInitialized(false){
@@ -156,6 +180,9 @@ struct DeclarativeStatement{
         delete m_dataType;
         delete m_identifier;
         delete m_expression;
+        for(Expression* element: m_elements){
+            delete element;
+        }
     }
 };
 
@@ -238,6 +265,8 @@ struct Function{
     Token* m_identifier;
     std::list<Parameter> m_parameters;
     std::list<Statement*> m_statements;
+    // results are cached by argument values
+    bool m_isMemo = false;
 
     Function(Token* returnType, Token* identifier)
         : m_returnType(returnType), m_identifier(identifier){
@@ -266,11 +295,16 @@ struct File{
     std::list<Token*> importPackages;
     std::list<Function*> functions;
     std::list<FunctionPrototype*> functionPrototypes;
+    // declarations outside of functions, private to the file
+    std::list<DeclarativeStatement*> globals;
 
     void free(){
         for(Function* function: functions){
             delete function;
         }
+        for(DeclarativeStatement* global: globals){
+            delete global;
+        }
         for(Token* package: importPackages){
             delete package;
         }
@@ -280,16 +314,28 @@ struct File{
     }
 };
 
+struct ArrayAccess{
+    Token* m_identifier;
+    Expression* m_index;
+
+    ArrayAccess(Token* identifier, Expression* index)
+        : m_identifier(identifier), m_index(index){
+    }
+
+    ~ArrayAccess();
+};
+
 struct Factor{
 
     union Operand{
         Token* value; // for literal or variable
         Expression* expression; // for expression inside expression eg ( 5 + 2 ) + 2
         FunctionCallStatement* functionCall; // for function calls within an expression eg : sum(2, 5)
+        ArrayAccess* arrayAccess; // for array elements eg : a[i + 1]
     } operand;
 
     enum class OperandType{
-        VALUE, EXPR, FUNCTION_CALL
+        VALUE, EXPR, FUNCTION_CALL, ARRAY_ACCESS
     } operandType;
 
     Factor(Expression* expression){
@@ -307,6 +353,11 @@ struct Factor{
         operandType = OperandType::FUNCTION_CALL;
     }
 
+    Factor(ArrayAccess* arrayAccess){
+        operand.arrayAccess = arrayAccess;
+        operandType = OperandType::ARRAY_ACCESS;
+    }
+
     ~Factor(){
         switch(operandType){
             case OperandType::VALUE:
@@ -317,6 +368,9 @@ struct Factor{
                 break;
             case OperandType::FUNCTION_CALL:
                 delete operand.functionCall;
+                break;
+            case OperandType::ARRAY_ACCESS:
+                delete operand.arrayAccess;
         };
     }
 
@@ -439,6 +493,11 @@ inline Expression::~Expression(){
     delete m_relational;
 }
 
+inline ArrayAccess::~ArrayAccess(){
+    delete m_identifier;
+    delete m_index;
+}
+
 inline ConditionalStatement::~ConditionalStatement(){
     delete m_else;
     for(Statement* stmnt: m_stmnts){
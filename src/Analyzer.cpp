@@ -2,16 +2,145 @@
 #include "AST.hpp"
 #include "SymbolTable.hpp"
 #include "Token.hpp"
+#include <algorithm>
+#include <functional>
+#include <iterator>
 #include <list>
 #include "ErrorHandler.hpp"
 #include <string_view>
 #include <sys/types.h>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+namespace{
+
+// returns the identifier when the additive is nothing but a variable
+Token* findIdentifier(ast::Additive& additive){
+    if(additive.m_additiveTail != nullptr){
+        return nullptr;
+    }
+    ast::Term& term = *additive.m_term;
+    if(term.m_termTail != nullptr || term.m_factor->operandType != ast::Factor::OperandType::VALUE){
+        return nullptr;
+    }
+    Token* value = term.m_factor->operand.value;
+    return value->m_tokenType.type == Type::IDENTIFIER ? value : nullptr;
+}
+
+// same for a whole expression, arrays are passed to functions this way
+Token* findIdentifier(ast::Expression& expression){
+    ast::Relational& relational = *expression.m_relational;
+    if(expression.m_expressionTail != nullptr || relational.m_relationalTail != nullptr){
+        return nullptr;
+    }
+    return findIdentifier(*relational.m_additive);
+}
+
+bool isSameIdentifier(const Token* token, const Token& identifier){
+    return token != nullptr && std::string_view(token->m_value, token->m_valueSize) == std::string_view(identifier.m_value, identifier.m_valueSize);
+}
+
+// true for: counter = counter + 1
+bool isIncrement(const ast::Statement& statement, const Token& counter){
+    if(statement.m_type != ast::Statement::Type::ASSIGNMENT){
+        return false;
+    }
+    const ast::AssignmentStatement& assignment = *statement.m_data.assignmentStatement;
+    if(!isSameIdentifier(assignment.m_identifier, counter) || assignment.m_index != nullptr){
+        return false;
+    }
+    ast::Expression& expression = *assignment.m_expression;
+    if(expression.m_expressionTail != nullptr || expression.m_relational->m_relationalTail != nullptr){
+        return false;
+    }
+    ast::Additive& additive = *expression.m_relational->m_additive;
+    ast::AdditiveTail* tail = additive.m_additiveTail;
+    if(tail == nullptr || tail->m_opcode != ast::Opcode::ADDITION || tail->m_additiveTail != nullptr || additive.m_term->m_termTail != nullptr){
+        return false;
+    }
+    const ast::Factor& step = *tail->m_term->m_factor;
+    if(tail->m_term->m_termTail != nullptr || step.operandType != ast::Factor::OperandType::VALUE){
+        return false;
+    }
+    const Token& stepValue = *step.operand.value;
+    return additive.m_term->m_factor->operandType == ast::Factor::OperandType::VALUE && isSameIdentifier(additive.m_term->m_factor->operand.value, counter) &&
+            stepValue.m_tokenType.type == Type::NUMERIC_LITERAL && std::string_view(stepValue.m_value, stepValue.m_valueSize) == "1";
+}
+
+// visits every factor of the expression, including the ones in call arguments and array indexes
+void forEachFactor(ast::Expression& expression, const std::function<void(ast::Factor&)>& visit){
+    auto visitFactor = [&](ast::Factor& factor){
+        visit(factor);
+        switch(factor.operandType){
+            case ast::Factor::OperandType::EXPR:
+                forEachFactor(*factor.operand.expression, visit);
+                break;
+            case ast::Factor::OperandType::FUNCTION_CALL:
+                for(ast::Expression* arg: factor.operand.functionCall->m_args){
+                    forEachFactor(*arg, visit);
+                }
+                break;
+            case ast::Factor::OperandType::ARRAY_ACCESS:
+                forEachFactor(*factor.operand.arrayAccess->m_index, visit);
+                break;
+            default:
+                break;
+        }
+    };
+    auto visitTerm = [&](ast::Term& term){
+        visitFactor(*term.m_factor);
+        for(ast::TermTail* termTail = term.m_termTail; termTail != nullptr; termTail = termTail->m_termTail){
+            visitFactor(*termTail->m_factor);
+        }
+    };
+    auto visitAdditive = [&](ast::Additive& additive){
+        visitTerm(*additive.m_term);
+        for(ast::AdditiveTail* additiveTail = additive.m_additiveTail; additiveTail != nullptr; additiveTail = additiveTail->m_additiveTail){
+            visitTerm(*additiveTail->m_term);
+        }
+    };
+    auto visitRelational = [&](ast::Relational& relational){
+        visitAdditive(*relational.m_additive);
+        for(ast::RelationalTail* relationalTail = relational.m_relationalTail; relationalTail != nullptr; relationalTail = relationalTail->m_relationalTail){
+            visitAdditive(*relationalTail->m_additive);
+        }
+    };
+    visitRelational(*expression.m_relational);
+    for(ast::ExpressionTail* exprTail = expression.m_expressionTail; exprTail != nullptr; exprTail = exprTail->m_expressionTail){
+        visitRelational(*exprTail->m_relational);
+    }
+}
+
+// errors about a whole relational are reported at its first token
+const Token& findFirstToken(const ast::Relational& relational){
+    const ast::Factor& factor = *relational.m_additive->m_term->m_factor;
+    switch(factor.operandType){
+        case ast::Factor::OperandType::EXPR:
+            return findFirstToken(*factor.operand.expression->m_relational);
+        case ast::Factor::OperandType::FUNCTION_CALL:
+            return *factor.operand.functionCall->m_identifier;
+        case ast::Factor::OperandType::ARRAY_ACCESS:
+            return *factor.operand.arrayAccess->m_identifier;
+        default:
+            return *factor.operand.value;
+    }
+}
+
+// scalars are broadcast to every lane where a vector is expected
+bool isCompatibleType(Keyword valueType, Keyword expectedType){
+    return valueType == expectedType || (getLaneCount(expectedType) != 0 && valueType == getElementType(expectedType));
+}
+
+}
 
 Analyzer::Analyzer(ast::File& syntaxTree, const ErrorHandler& errorHandler)
-    : m_syntaxTree(syntaxTree), m_errorHandler(errorHandler), m_symbolTableHandler(errorHandler){
+    : m_syntaxTree(syntaxTree), m_errorHandler(errorHandler), m_symbolTableHandler(errorHandler), m_interpreter(syntaxTree.functions, syntaxTree.globals){
+}
+
+Analyzer::Analyzer(ast::File& syntaxTree, const ErrorHandler& errorHandler, const std::list<ast::Function*>& importedFunctions)
+    : m_syntaxTree(syntaxTree), m_errorHandler(errorHandler), m_symbolTableHandler(errorHandler), m_interpreter(syntaxTree.functions, syntaxTree.globals),
+      m_importedFunctions(importedFunctions){
 }
 
 void Analyzer::analyze(){
@@ -26,10 +155,16 @@ void Analyzer::analyze(){
                 m_errorHandler.reportError("Main function should return int", *function.m_returnType);
             }
         }
+        if(function.m_isMemo){
+            analyzeMemoSignature(function);
+        }
         m_symbolTableHandler.createSymbolTable();
         for(ast::Parameter param: function.m_parameters){
             std::string_view paramIdentifier(param.m_identifier->m_value, param.m_identifier->m_valueSize);
-            m_symbolTableHandler.updateSymbolTable(param.m_dataType->m_tokenType.keywordType, paramIdentifier, true, false);
+            if(m_symbolTableHandler.findVariableSymbol(paramIdentifier).first){
+                m_errorHandler.reportError(error::DUPLICATE_VAR, *param.m_identifier);
+            }
+            m_symbolTableHandler.updateSymbolTable(param.m_dataType->m_tokenType.keywordType, paramIdentifier, true, false, param.m_arraySize);
         }
         bool returnStatementFound = false;
         for(auto statement: function.m_statements){
@@ -44,16 +179,71 @@ void Analyzer::analyze(){
         m_symbolTableHandler.popSymbolTabe();
     };
     
+    for(auto function: m_importedFunctions){
+        m_symbolTableHandler.updateSymbolTable(*function);
+    }
+    for(auto global: m_syntaxTree.globals){
+        analyzeGlobalDeclaration(*global);
+    }
     for(auto function: m_syntaxTree.functions){
         m_symbolTableHandler.updateSymbolTable(*function);
         evaluateFunction(*function);
     }
 }
 
+// arguments are the key of the memo table, so they have to be compared by value.
+// a cached result is only valid when nothing but the arguments decides it
+void Analyzer::analyzeMemoSignature(ast::Function& function){
+    if(!m_interpreter.isPure(function)){
+        m_errorHandler.reportError(error::MEMO_NOT_PURE, *function.m_identifier);
+    }
+    const Keyword returnType = function.m_returnType->m_tokenType.keywordType;
+    if(returnType != Keyword::INT && returnType != Keyword::CHAR && returnType != Keyword::FLOAT){
+        m_errorHandler.reportError(error::MEMO_SIGNATURE, *function.m_returnType);
+    }
+    for(ast::Parameter& param: function.m_parameters){
+        const Keyword paramType = param.m_dataType->m_tokenType.keywordType;
+        if(param.m_arraySize != 0 || (paramType != Keyword::INT && paramType != Keyword::CHAR)){
+            m_errorHandler.reportError(error::MEMO_SIGNATURE, *param.m_identifier);
+        }
+    }
+}
+
+// globals are in place before main runs, so their initializers have to be known at compile time
+void Analyzer::analyzeGlobalDeclaration(ast::DeclarativeStatement& declarativeStatement){
+    analyzeDeclarativeStatement(declarativeStatement);
+    ConstantValue value;
+    if(declarativeStatement.m_expression != nullptr && !foldConstants(*declarativeStatement.m_expression, value)){
+        m_errorHandler.reportError(error::GLOBAL_NOT_CONSTANT, *declarativeStatement.m_identifier);
+    }
+    for(ast::Expression* element: declarativeStatement.m_elements){
+        if(!foldConstants(*element, value)){
+            m_errorHandler.reportError(error::GLOBAL_NOT_CONSTANT, *declarativeStatement.m_identifier);
+        }
+    }
+}
+
 void Analyzer::analyzeDeclarativeStatement(ast::DeclarativeStatement& declarativeStatement){
-    Keyword expectedType = declarativeStatement.m_dataType->m_tokenType.keywordType;\
+    Keyword expectedType = declarativeStatement.m_dataType->m_tokenType.keywordType;
+    if(declarativeStatement.m_isConst && !declarativeStatement.m_isInitialized){
+        m_errorHandler.reportError(error::CONST_NOT_INITIALIZED, *declarativeStatement.m_identifier);
+    }
+    if(declarativeStatement.m_elements.size() > declarativeStatement.m_arraySize){
+        m_errorHandler.reportError(error::TOO_MANY_ELEMENTS, *declarativeStatement.m_identifier);
+    }
+    for(ast::Expression* element: declarativeStatement.m_elements){
+        performTypeChecking(*element, expectedType);
+        foldConstants(*element);
+    }
     if(declarativeStatement.m_expression != nullptr){
         performTypeChecking(*declarativeStatement.m_expression, expectedType);
+        ConstantValue value;
+        // folded values are scalars, const vectors are kept as variables
+        if(foldConstants(*declarativeStatement.m_expression, value) && declarativeStatement.m_isConst && getLaneCount(expectedType) == 0){
+            declarativeStatement.m_isCompileTimeConstant = true;
+            m_symbolTableHandler.updateSymbolTable(declarativeStatement, value);
+            return;
+        }
     }
     m_symbolTableHandler.updateSymbolTable(declarativeStatement);
 }
@@ -61,7 +251,18 @@ void Analyzer::analyzeDeclarativeStatement(ast::DeclarativeStatement& declarativ
 void Analyzer::analyzeAssignmentStatement(ast::AssignmentStatement& assignmentStatement){
    Token& identifierToken = *assignmentStatement.m_identifier;
    Keyword dataType = findVariableType(identifierToken);
+   std::string_view varName(identifierToken.m_value, identifierToken.m_valueSize);
+   const SymbolTableEntry variable = m_symbolTableHandler.findVariableSymbol(varName).second;
+   if(variable.isConst){
+       m_errorHandler.reportError(error::CONST_ASSIGNMENT, identifierToken);
+   }
+   if(assignmentStatement.m_index != nullptr){
+       dataType = analyzeArrayIndex(identifierToken, *assignmentStatement.m_index);
+   }else if(variable.isArray){
+       m_errorHandler.reportError(error::ARRAY_AS_VALUE, identifierToken);
+   }
    performTypeChecking(*assignmentStatement.m_expression, dataType);
+   foldConstants(*assignmentStatement.m_expression);
 }
 
 
@@ -86,6 +287,8 @@ Keyword Analyzer::findFirstValueType(ast::Relational& relational){
         return findFirstValueType(*factor.operand.expression);
     }else if(factor.operandType == ast::Factor::OperandType::FUNCTION_CALL){
         return analyzeFunctionCallStatement(*factor.operand.functionCall);
+    }else if(factor.operandType == ast::Factor::OperandType::ARRAY_ACCESS){
+        return analyzeArrayIndex(*factor.operand.arrayAccess->m_identifier, *factor.operand.arrayAccess->m_index);
     }
     return Keyword::NIL;
 }
@@ -97,9 +300,7 @@ Keyword Analyzer::findFirstValueType(ast::Expression& expression){
 
 void Analyzer::analyzeConditionalStatement(ast::ConditionalStatement& conditionalStatement, ast::Function& currentFunction){
     if(conditionalStatement.m_expr != nullptr){
-        ast::Expression& expr = *conditionalStatement.m_expr;
-        Keyword expectedType = findFirstValueType(expr);
-        performTypeChecking(expr, expectedType);
+        analyzeCondition(*conditionalStatement.m_expr);
     }
     analyzeNestedScope(conditionalStatement.m_stmnts, currentFunction);
     if(conditionalStatement.m_else != nullptr){
@@ -107,6 +308,16 @@ void Analyzer::analyzeConditionalStatement(ast::ConditionalStatement& conditiona
     }
 }   
 
+// conditions are scalar, vectors have to be reduced or compared lane by lane first
+void Analyzer::analyzeCondition(ast::Expression& expr){
+    Keyword expectedType = findFirstValueType(expr);
+    if(getLaneCount(expectedType) != 0){
+        m_errorHandler.reportError(error::VECTOR_COMPARISON, findFirstToken(*expr.m_relational));
+    }
+    performTypeChecking(expr, expectedType);
+    foldConstants(expr);
+}
+
 void Analyzer::analyzeNestedScope(std::list<ast::Statement*> stmnts, ast::Function& currentFunction){
     m_symbolTableHandler.createSymbolTable();
     for(auto statement: stmnts){
@@ -121,19 +332,156 @@ void Analyzer::analyzeReturnStatement(ast::ReturnStatement& returnStatement, ast
     }
     Keyword expectedType = currentFunction.m_returnType->m_tokenType.keywordType;
     performTypeChecking(*returnStatement.m_expr, expectedType);
+    foldConstants(*returnStatement.m_expr);
 }
 
 void Analyzer::analyzeWhileLoop(ast::WhileLoop& whileLoop, ast::Function& currentFunction){
-    ast::Expression& expr = *whileLoop.m_expr;
-    Keyword expectedType = findFirstValueType(expr);
-    performTypeChecking(expr, expectedType);
+    analyzeCondition(*whileLoop.m_expr);
 
     analyzeNestedScope(whileLoop.m_stmnts, currentFunction);
+    if(whileLoop.m_hints.m_parallel){
+        analyzeParallelLoop(whileLoop);
+    }
+}
+
+/*
+    Parallel loops have the form while(i < n) parallel { ... i = i + 1; } with an int counter only stepped
+    by the last statement, n is evaluated once. Iterations run in any order and at the same time, so the
+    body can only assign to its own variables and to elements [i] of shared arrays, reads of an array it
+    writes are also limited to [i], shared arrays cannot be passed to functions and it cannot return.
+*/
+void Analyzer::analyzeParallelLoop(ast::WhileLoop& whileLoop){
+    ast::Expression& condition = *whileLoop.m_expr;
+    ast::RelationalTail* bound = condition.m_relational->m_relationalTail;
+    Token* counter = findIdentifier(*condition.m_relational->m_additive);
+    if(condition.m_expressionTail != nullptr || bound == nullptr || bound->m_opcode != ast::Opcode::SMALLER_THAN || bound->m_relationalTail != nullptr ||
+            counter == nullptr){
+        m_errorHandler.reportError(error::PARALLEL_LOOP_FORM, findFirstToken(*condition.m_relational));
+    }
+    std::string_view counterName(counter->m_value, counter->m_valueSize);
+    SymbolTableEntry counterEntry = m_symbolTableHandler.findVariableSymbol(counterName).second;
+    if(counterEntry.dataType != Keyword::INT || counterEntry.isArray || counterEntry.isGlobal || whileLoop.m_stmnts.empty() || !isIncrement(*whileLoop.m_stmnts.back(), *counter)){
+        m_errorHandler.reportError(error::PARALLEL_LOOP_FORM, *counter);
+    }
+    ParallelBody body{*counter};
+    std::list<ast::Statement*> stmnts(whileLoop.m_stmnts.begin(), std::prev(whileLoop.m_stmnts.end()));
+    analyzeParallelBody(stmnts, body);
+    for(const ast::ArrayAccess* read: body.arrayReads){
+        std::string_view arrayName(read->m_identifier->m_value, read->m_identifier->m_valueSize);
+        if(std::find(body.writtenArrays.begin(), body.writtenArrays.end(), arrayName) != body.writtenArrays.end() &&
+                !isSameIdentifier(findIdentifier(*read->m_index), body.counter)){
+            m_errorHandler.reportError(error::PARALLEL_ARRAY_INDEX, *read->m_identifier);
+        }
+    }
+}
+
+void Analyzer::analyzeParallelBody(const std::list<ast::Statement*>& stmnts, ParallelBody& body){
+    auto isLocal = [&](const Token& identifier){
+        std::string_view varName(identifier.m_value, identifier.m_valueSize);
+        return std::find(body.localVariables.begin(), body.localVariables.end(), varName) != body.localVariables.end();
+    };
+    for(ast::Statement* statement: stmnts){
+        switch(statement->m_type){
+            case ast::Statement::Type::DECLARATIVE:
+                {
+                    ast::DeclarativeStatement& declaration = *statement->m_data.declarativeStatement;
+                    if(declaration.m_expression != nullptr){
+                        analyzeParallelExpression(*declaration.m_expression, body);
+                    }
+                    for(ast::Expression* element: declaration.m_elements){
+                        analyzeParallelExpression(*element, body);
+                    }
+                    body.localVariables.push_back(std::string_view(declaration.m_identifier->m_value, declaration.m_identifier->m_valueSize));
+                }
+                break;
+            case ast::Statement::Type::ASSIGNMENT:
+                {
+                    ast::AssignmentStatement& assignment = *statement->m_data.assignmentStatement;
+                    analyzeParallelExpression(*assignment.m_expression, body);
+                    if(assignment.m_index != nullptr){
+                        analyzeParallelExpression(*assignment.m_index, body);
+                    }
+                    if(isLocal(*assignment.m_identifier)){
+                        break;
+                    }
+                    std::string_view varName(assignment.m_identifier->m_value, assignment.m_identifier->m_valueSize);
+                    if(assignment.m_index == nullptr || !m_symbolTableHandler.findVariableSymbol(varName).second.isArray){
+                        m_errorHandler.reportError(error::PARALLEL_SHARED_ASSIGNMENT, *assignment.m_identifier);
+                    }
+                    // iterations only ever touch their own element, so no two of them write the same one
+                    if(!isSameIdentifier(findIdentifier(*assignment.m_index), body.counter)){
+                        m_errorHandler.reportError(error::PARALLEL_ARRAY_INDEX, *assignment.m_identifier);
+                    }
+                    body.writtenArrays.push_back(varName);
+                }
+                break;
+            case ast::Statement::Type::CONDITIONAL:
+                for(ast::ConditionalStatement* arm = statement->m_data.conditionalStatement; arm != nullptr; arm = arm->m_else){
+                    if(arm->m_expr != nullptr){
+                        analyzeParallelExpression(*arm->m_expr, body);
+                    }
+                    analyzeParallelBody(arm->m_stmnts, body);
+                }
+                break;
+            case ast::Statement::Type::WHILE_LOOP:
+                analyzeParallelExpression(*statement->m_data.whileLoop->m_expr, body);
+                analyzeParallelBody(statement->m_data.whileLoop->m_stmnts, body);
+                break;
+            case ast::Statement::Type::RETURN:
+                m_errorHandler.reportError(error::PARALLEL_RETURN, *statement->m_data.returnStatement->m_keyword);
+                return;
+            case ast::Statement::Type::FUNCTION_CALL:
+                {
+                    ast::FunctionCallStatement& functionCall = *statement->m_data.functionalCallStatement;
+                    analyzeParallelCall(functionCall, body);
+                    for(ast::Expression* arg: functionCall.m_args){
+                        analyzeParallelExpression(*arg, body);
+                    }
+                }
+                break;
+        }
+    }
+}
+
+// records the shared arrays read by the expression, they are checked against the writes once the whole body is known
+void Analyzer::analyzeParallelExpression(ast::Expression& expression, ParallelBody& body){
+    forEachFactor(expression, [&](ast::Factor& factor){
+        if(factor.operandType == ast::Factor::OperandType::FUNCTION_CALL){
+            analyzeParallelCall(*factor.operand.functionCall, body);
+        }else if(factor.operandType == ast::Factor::OperandType::ARRAY_ACCESS){
+            const Token& identifier = *factor.operand.arrayAccess->m_identifier;
+            std::string_view varName(identifier.m_value, identifier.m_valueSize);
+            if(std::find(body.localVariables.begin(), body.localVariables.end(), varName) == body.localVariables.end()){
+                body.arrayReads.push_back(factor.operand.arrayAccess);
+            }
+        }
+    });
+}
+
+// the callee could touch any element of an array it is given, and globals are shared by all iterations
+void Analyzer::analyzeParallelCall(const ast::FunctionCallStatement& functionCall, const ParallelBody& body){
+    if(m_interpreter.writesGlobals(functionCall)){
+        m_errorHandler.reportError(error::PARALLEL_GLOBAL_WRITE, *functionCall.m_identifier);
+    }
+    for(ast::Expression* arg: functionCall.m_args){
+        Token* identifier = findIdentifier(*arg);
+        if(identifier == nullptr){
+            continue;
+        }
+        std::string_view varName(identifier->m_value, identifier->m_valueSize);
+        if(std::find(body.localVariables.begin(), body.localVariables.end(), varName) == body.localVariables.end() &&
+                m_symbolTableHandler.findVariableSymbol(varName).second.isArray){
+            m_errorHandler.reportError(error::PARALLEL_ARRAY_ARGUMENT, *identifier);
+        }
+    }
 }
 
 Keyword Analyzer::analyzeFunctionCallStatement(ast::FunctionCallStatement& functionCallStatement){
     Token& functionIdentifier = *functionCallStatement.m_identifier;
     const std::string_view identifier(functionIdentifier.m_value, functionIdentifier.m_valueSize);
+    if(SymbolTableHandler::isVectorReduction(identifier)){
+        return analyzeVectorReduction(functionCallStatement);
+    }
     auto result = m_symbolTableHandler.findFunctionSymbol(identifier);
     if(result.first == false){
         m_errorHandler.reportError(error::FUCTION_NOT_FOUND, functionIdentifier);
@@ -145,10 +493,17 @@ Keyword Analyzer::analyzeFunctionCallStatement(ast::FunctionCallStatement& funct
         if(args.size() == 0 && params.size() == 0){
             return true;
         }
-        std::vector<Keyword>::iterator param = params.begin();
+        const std::vector<uint32_t>& paramArraySizes = result.second.paramArraySizes;
+        std::vector<std::string_view> passedArrays;
+        size_t paramIndex = 0;
         for(ast::Expression* expr : args){
-            performTypeChecking(*expr, *param);
-            param++;
+            if(paramIndex < paramArraySizes.size() && paramArraySizes[paramIndex] != 0){
+                analyzeArrayArgument(functionCallStatement, *expr, params[paramIndex], paramArraySizes[paramIndex], passedArrays);
+            }else{
+                performTypeChecking(*expr, params[paramIndex]);
+                foldConstants(*expr);
+            }
+            paramIndex++;
         }
         return true;
     };
@@ -158,6 +513,76 @@ Keyword Analyzer::analyzeFunctionCallStatement(ast::FunctionCallStatement& funct
     return result.second.dataType;
 }
 
+// the vector type is taken from the first value of the argument, reductions return its element type
+Keyword Analyzer::analyzeVectorReduction(ast::FunctionCallStatement& functionCallStatement){
+    if(functionCallStatement.m_args.size() != 1){
+        m_errorHandler.reportError(error::NOT_A_VECTOR, *functionCallStatement.m_identifier);
+    }
+    ast::Expression& arg = *functionCallStatement.m_args.front();
+    Keyword vectorType = findFirstValueType(arg);
+    if(getLaneCount(vectorType) == 0){
+        m_errorHandler.reportError(error::NOT_A_VECTOR, *functionCallStatement.m_identifier);
+    }
+    performTypeChecking(arg, vectorType);
+    foldConstants(arg);
+    return getElementType(vectorType);
+}
+
+/*
+    Checks that identifier is an array or a vector and index an int expression.
+    Constant indexes are checked against the array size or lane count. Returns the element type.
+*/
+Keyword Analyzer::analyzeArrayIndex(Token& identifier, ast::Expression& index){
+    std::string_view varName(identifier.m_value, identifier.m_valueSize);
+    auto symbolEntry = m_symbolTableHandler.findVariableSymbol(varName);
+    if(symbolEntry.first == false){
+        m_errorHandler.reportError(error::VARIABLE_NOT_FOUND, identifier);
+    }
+    uint32_t size = symbolEntry.second.arraySize;
+    Keyword elementType = symbolEntry.second.dataType;
+    if(!symbolEntry.second.isArray){
+        // lanes of a vector variable are indexed like array elements
+        size = getLaneCount(elementType);
+        elementType = getElementType(elementType);
+    }
+    if(size == 0){
+        m_errorHandler.reportError(error::NOT_AN_ARRAY, identifier);
+    }
+    performTypeChecking(index, Keyword::INT);
+    ConstantValue value;
+    if(foldConstants(index, value) && (value.intValue < 0 || static_cast<uint32_t>(value.intValue) >= size)){
+        m_errorHandler.reportError(error::INDEX_OUT_OF_BOUNDS, identifier);
+    }
+    return elementType;
+}
+
+// array arguments must name an array of the parameter type and size, each array at most once per call since parameters do not alias
+void Analyzer::analyzeArrayArgument(const ast::FunctionCallStatement& functionCall, ast::Expression& arg, Keyword paramType, uint32_t paramArraySize,
+        std::vector<std::string_view>& passedArrays){
+    Token* identifier = findIdentifier(arg);
+    if(identifier == nullptr){
+        m_errorHandler.reportError(error::ARGS_PARAM_ERROR, *functionCall.m_identifier);
+    }
+    std::string_view varName(identifier->m_value, identifier->m_valueSize);
+    auto symbolEntry = m_symbolTableHandler.findVariableSymbol(varName);
+    if(symbolEntry.first == false){
+        m_errorHandler.reportError(error::VARIABLE_NOT_FOUND, *identifier);
+    }
+    if(!symbolEntry.second.isArray || symbolEntry.second.dataType != paramType || symbolEntry.second.arraySize != paramArraySize){
+        m_errorHandler.reportError(error::ARGS_PARAM_ERROR, *identifier);
+    }
+    // array parameters are writable
+    if(symbolEntry.second.isConst){
+        m_errorHandler.reportError(error::CONST_ARRAY_ARGUMENT, *identifier);
+    }
+    for(std::string_view passedArray: passedArrays){
+        if(passedArray == varName){
+            m_errorHandler.reportError(error::ARRAY_PASSED_TWICE, *identifier);
+        }
+    }
+    passedArrays.push_back(varName);
+}
+
 void Analyzer::analyzeStatement(ast::Statement& statement, ast::Function& currentFunction){
     switch(statement.m_type){
         case ast::Statement::Type::CONDITIONAL:
@@ -185,13 +610,13 @@ void Analyzer::performTypeChecking(ast::Factor& factor, Keyword expectedDataType
 
     auto checkIfValueTypeIsCompatible = [&](Token& value, Keyword expectedType){
         if(value.m_tokenType.type == Type::NUMERIC_LITERAL){
-            if(value.m_tokenType.isFloatingPointValue && expectedType != Keyword::FLOAT){
+            if(value.m_tokenType.isFloatingPointValue && !isCompatibleType(Keyword::FLOAT, expectedType)){
                 m_errorHandler.reportError(error::INVALID_EXPR, value);
-            }else if(!value.m_tokenType.isFloatingPointValue && expectedDataType != Keyword::INT){
+            }else if(!value.m_tokenType.isFloatingPointValue && !isCompatibleType(Keyword::INT, expectedType)){
                 m_errorHandler.reportError(error::INVALID_EXPR, value);
             }
         }else if(value.m_tokenType.type == Type::STRING_LITERAL){
-            if(expectedType != Keyword::CHAR){
+            if(!isCompatibleType(Keyword::CHAR, expectedType)){
                 m_errorHandler.reportError(error::INVALID_EXPR, value);
             }
             if(value.m_valueSize > 1){
@@ -199,9 +624,13 @@ void Analyzer::performTypeChecking(ast::Factor& factor, Keyword expectedDataType
             }
         }else if(value.m_tokenType == Type::IDENTIFIER){
             Keyword dataType = findVariableType(value);
-            if(dataType != expectedDataType){
+            if(!isCompatibleType(dataType, expectedDataType)){
                 m_errorHandler.reportError(error::INVALID_EXPR, value);
             }
+            std::string_view varName(value.m_value, value.m_valueSize);
+            if(m_symbolTableHandler.findVariableSymbol(varName).second.isArray){
+                m_errorHandler.reportError(error::ARRAY_AS_VALUE, value);
+            }
         }
     };
     switch(factor.operandType){
@@ -212,9 +641,19 @@ void Analyzer::performTypeChecking(ast::Factor& factor, Keyword expectedDataType
             performTypeChecking(*factor.operand.expression, expectedDataType);
             break;
         case ast::Factor::OperandType::FUNCTION_CALL:
-            Keyword functionReturnType = analyzeFunctionCallStatement(*factor.operand.functionCall);
-            if(functionReturnType != expectedDataType){
-                m_errorHandler.reportError(error::UNEXPECTED_RETURN, *factor.operand.functionCall->m_identifier);
+            {
+                Keyword functionReturnType = analyzeFunctionCallStatement(*factor.operand.functionCall);
+                if(!isCompatibleType(functionReturnType, expectedDataType)){
+                    m_errorHandler.reportError(error::UNEXPECTED_RETURN, *factor.operand.functionCall->m_identifier);
+                }
+            }
+            break;
+        case ast::Factor::OperandType::ARRAY_ACCESS:
+            {
+                ast::ArrayAccess& arrayAccess = *factor.operand.arrayAccess;
+                if(!isCompatibleType(analyzeArrayIndex(*arrayAccess.m_identifier, *arrayAccess.m_index), expectedDataType)){
+                    m_errorHandler.reportError(error::INVALID_EXPR, *arrayAccess.m_identifier);
+                }
             }
             break;
     }
@@ -231,13 +670,16 @@ Keyword Analyzer::findVariableType(Token& identifier){
 
 void Analyzer::performTypeChecking(ast::DeclarativeStatement& declarativeStatement){
     Token& dataTypeToken = *declarativeStatement.m_dataType;
-    if(declarativeStatement.m_isInitialized){
+    if(declarativeStatement.m_expression != nullptr){
         performTypeChecking(*declarativeStatement.m_expression, dataTypeToken.m_tokenType.keywordType);
     }
 }
 
 void Analyzer::performTypeChecking(ast::Expression& expression, Keyword expectedDataType){
     performTypeChecking(*expression.m_relational, expectedDataType);
+    if(expression.m_expressionTail != nullptr && getLaneCount(expectedDataType) != 0){
+        m_errorHandler.reportError(error::VECTOR_COMPARISON, findFirstToken(*expression.m_relational));
+    }
 
     ast::ExpressionTail* exprTail = expression.m_expressionTail;
     while(exprTail != nullptr){
@@ -248,6 +690,9 @@ void Analyzer::performTypeChecking(ast::Expression& expression, Keyword expected
 
 void Analyzer::performTypeChecking(ast::Relational& relational, Keyword expectedDataType){
     performTypeChecking(*relational.m_additive, expectedDataType);
+    if(relational.m_relationalTail != nullptr && getLaneCount(expectedDataType) != 0){
+        m_errorHandler.reportError(error::VECTOR_COMPARISON, findFirstToken(relational));
+    }
 
     ast::RelationalTail* relationalTail = relational.m_relationalTail;
     while(relationalTail != nullptr){
@@ -274,4 +719,156 @@ void Analyzer::performTypeChecking(ast::Term& term, Keyword expectedDataType){
         performTypeChecking(*termTail->m_factor, expectedDataType);
         termTail = termTail->m_termTail;
     }
-}
\ No newline at end of file
+}
+
+void Analyzer::foldConstants(ast::Expression& expression){
+    ConstantValue value;
+    foldConstants(expression, value);
+}
+
+/*
+    Each foldConstants overload returns true when the whole node evaluates to a constant,
+    in which case the node is rewritten to hold a single literal factor.
+    Literal only prefixes of longer chains are folded as well eg: 2 * 3 * x -> 6 * x
+*/
+bool Analyzer::foldConstants(ast::Expression& expression, ConstantValue& result){
+    bool isConstant = foldConstants(*expression.m_relational, result);
+
+    ast::ExpressionTail* exprTail = expression.m_expressionTail;
+    while(exprTail != nullptr){
+        ConstantValue value;
+        foldConstants(*exprTail->m_relational, value);
+        exprTail = exprTail->m_expressionTail;
+    }
+    return isConstant && expression.m_expressionTail == nullptr;
+}
+
+bool Analyzer::foldConstants(ast::Relational& relational, ConstantValue& result){
+    bool isConstant = foldConstants(*relational.m_additive, result);
+
+    ast::RelationalTail* relationalTail = relational.m_relationalTail;
+    while(relationalTail != nullptr){
+        ConstantValue value;
+        foldConstants(*relationalTail->m_additive, value);
+        relationalTail = relationalTail->m_relationalTail;
+    }
+    // comparisons produce a boolean which has no literal form, so they are left for codegen
+    return isConstant && relational.m_relationalTail == nullptr;
+}
+
+bool Analyzer::foldConstants(ast::Additive& additive, ConstantValue& result){
+    bool isConstant = foldConstants(*additive.m_term, result);
+    bool isFolded = false;
+
+    ast::AdditiveTail* additiveTail = additive.m_additiveTail;
+    while(isConstant && additiveTail != nullptr){
+        ConstantValue value;
+        if(!foldConstants(*additiveTail->m_term, value) || !constant::evaluate(additiveTail->m_opcode, result, value, result)){
+            isConstant = false;
+            break;
+        }
+        additive.m_additiveTail = additiveTail->m_additiveTail;
+        additiveTail->m_additiveTail = nullptr;
+        delete additiveTail;
+        additiveTail = additive.m_additiveTail;
+        isFolded = true;
+    }
+    if(isFolded){
+        Token* literal = additive.m_term->m_factor->operand.value;
+        additive.m_term->m_factor->operand.value = constant::createLiteral(result, literal->m_lineNumber);
+        delete literal;
+    }
+    while(additiveTail != nullptr){
+        ConstantValue value;
+        foldConstants(*additiveTail->m_term, value);
+        additiveTail = additiveTail->m_additiveTail;
+    }
+    return isConstant;
+}
+
+bool Analyzer::foldConstants(ast::Term& term, ConstantValue& result){
+    bool isConstant = foldConstants(*term.m_factor, result);
+    bool isFolded = false;
+
+    ast::TermTail* termTail = term.m_termTail;
+    while(isConstant && termTail != nullptr){
+        ConstantValue value;
+        if(!foldConstants(*termTail->m_factor, value) || !constant::evaluate(termTail->m_opcode, result, value, result)){
+            isConstant = false;
+            break;
+        }
+        term.m_termTail = termTail->m_termTail;
+        termTail->m_termTail = nullptr;
+        delete termTail;
+        termTail = term.m_termTail;
+        isFolded = true;
+    }
+    if(isFolded){
+        Token* literal = term.m_factor->operand.value;
+        term.m_factor->operand.value = constant::createLiteral(result, literal->m_lineNumber);
+        delete literal;
+    }
+    while(termTail != nullptr){
+        ConstantValue value;
+        foldConstants(*termTail->m_factor, value);
+        termTail = termTail->m_termTail;
+    }
+    return isConstant;
+}
+
+bool Analyzer::foldConstants(ast::Factor& factor, ConstantValue& result){
+    switch(factor.operandType){
+        case ast::Factor::OperandType::VALUE:
+            {
+                Token& value = *factor.operand.value;
+                if(value.m_tokenType.type != Type::IDENTIFIER){
+                    return constant::fromLiteral(value, result);
+                }
+                std::string_view varName(value.m_value, value.m_valueSize);
+                auto symbolEntry = m_symbolTableHandler.findVariableSymbol(varName);
+                if(!symbolEntry.first || !symbolEntry.second.hasConstantValue){
+                    return false;
+                }
+                result = symbolEntry.second.constantValue;
+                factor.operand.value = constant::createLiteral(result, value.m_lineNumber);
+                delete &value;
+                return true;
+            }
+        case ast::Factor::OperandType::EXPR:
+            {
+                ast::Expression* expression = factor.operand.expression;
+                if(!foldConstants(*expression, result)){
+                    return false;
+                }
+                Token* literal = expression->m_relational->m_additive->m_term->m_factor->operand.value;
+                factor.operand.value = constant::createLiteral(result, literal->m_lineNumber);
+                factor.operandType = ast::Factor::OperandType::VALUE;
+                delete expression;
+                return true;
+            }
+        case ast::Factor::OperandType::FUNCTION_CALL:
+            {
+                // calls of pure functions with constant args are evaluated at compile time
+                ast::FunctionCallStatement* functionCall = factor.operand.functionCall;
+                std::vector<ConstantValue> args;
+                for(ast::Expression* arg: functionCall->m_args){
+                    ConstantValue value;
+                    if(!foldConstants(*arg, value)){
+                        return false;
+                    }
+                    args.push_back(value);
+                }
+                if(!m_interpreter.evaluate(*functionCall, args, result)){
+                    return false;
+                }
+                factor.operand.value = constant::createLiteral(result, functionCall->m_identifier->m_lineNumber);
+                factor.operandType = ast::Factor::OperandType::VALUE;
+                delete functionCall;
+                return true;
+            }
+        case ast::Factor::OperandType::ARRAY_ACCESS:
+            // index is folded while type checking, elements are only known at runtime
+            return false;
+    }
+    return false;
+}
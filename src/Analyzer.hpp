@@ -1,5 +1,7 @@
 #pragma once
 #include "AST.hpp"
+#include "ConstantValue.hpp"
+#include "Interpreter.hpp"
 #include "ErrorHandler.hpp"
 #include "SymbolTable.hpp"
 #include "Token.hpp"
@@ -10,17 +12,37 @@ class Analyzer{
 
 public:
     Analyzer(ast::File& syntaxTree, const ErrorHandler& errorHandler);
+    // functions of imported files, callable from the analyzed file
+    Analyzer(ast::File& syntaxTree, const ErrorHandler& errorHandler, const std::list<ast::Function*>& importedFunctions);
     void analyze();
     
 private:    
     void analyzeStatement(ast::Statement& statement, ast::Function& currentFunction);
     void analyzeConditionalStatement(ast::ConditionalStatement& conditionalStatement, ast::Function& currentFunction);
+    void analyzeMemoSignature(ast::Function& function);
+    void analyzeGlobalDeclaration(ast::DeclarativeStatement& declarativeStatement);
     void analyzeDeclarativeStatement(ast::DeclarativeStatement& declarativeStatement);
     void analyzeAssignmentStatement(ast::AssignmentStatement& assignmentStatement);
     Keyword analyzeFunctionCallStatement(ast::FunctionCallStatement& functionCallStatement);
+    Keyword analyzeVectorReduction(ast::FunctionCallStatement& functionCallStatement);
+    Keyword analyzeArrayIndex(Token& identifier, ast::Expression& index);
+    void analyzeArrayArgument(const ast::FunctionCallStatement& functionCall, ast::Expression& arg, Keyword paramType, uint32_t paramArraySize,
+            std::vector<std::string_view>& passedArrays);
     void analyzeReturnStatement(ast::ReturnStatement& returnStatement, ast::Function& currentFunction);
+    void analyzeCondition(ast::Expression& expr);
     void analyzeNestedScope(std::list<ast::Statement*> stmnts, ast::Function& currentFunction);
     void analyzeWhileLoop(ast::WhileLoop& whileLoop, ast::Function& currentFunction);
+    void analyzeParallelLoop(ast::WhileLoop& whileLoop);
+    // variables declared by the body of a parallel loop and the shared arrays it reads and writes
+    struct ParallelBody{
+        const Token& counter;
+        std::vector<std::string_view> localVariables;
+        std::vector<std::string_view> writtenArrays;
+        std::vector<const ast::ArrayAccess*> arrayReads;
+    };
+    void analyzeParallelBody(const std::list<ast::Statement*>& stmnts, ParallelBody& body);
+    void analyzeParallelExpression(ast::Expression& expression, ParallelBody& body);
+    void analyzeParallelCall(const ast::FunctionCallStatement& functionCall, const ParallelBody& body);
     void performTypeChecking(ast::DeclarativeStatement& declarativeStatement);
     void performTypeChecking(ast::ReturnStatement& returnStatement, ast::Function& function);
     void performTypeChecking(ast::AssignmentStatement& assignmentStatement);
@@ -32,6 +54,13 @@ private:
     void performTypeChecking(ast::Factor& additive, Keyword expectedDataType);
     void performTypeChecking(ast::Statement& statement, ast::Function& function);
 
+    bool foldConstants(ast::Expression& expression, ConstantValue& result);
+    bool foldConstants(ast::Relational& relational, ConstantValue& result);
+    bool foldConstants(ast::Additive& additive, ConstantValue& result);
+    bool foldConstants(ast::Term& term, ConstantValue& result);
+    bool foldConstants(ast::Factor& factor, ConstantValue& result);
+    void foldConstants(ast::Expression& expression);
+
     Keyword findFirstValueType(ast::Expression& expr);
     Keyword findFirstValueType(ast::Relational& relational);
 
@@ -39,6 +68,8 @@ private:
     Keyword findVariableType(Token& identifier);
     std::list<SymbolTable> m_symbolTableList;
     SymbolTableHandler m_symbolTableHandler;
+    Interpreter m_interpreter;
     ast::File& m_syntaxTree;
+    std::list<ast::Function*> m_importedFunctions;
 };
 
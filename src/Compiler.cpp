@@ -2,67 +2,274 @@
 #include "AST.hpp"
 #include "Analyzer.hpp"
 #include "ErrorHandler.hpp"
+#include <chrono>
 #include <cstdio>
+#include <iomanip>
+#include <iostream>
 #include "IRGenerator.hpp"
+#include "Linker.hpp"
 #include "Parser.hpp"
+#include "ThreadPool.hpp"
 #include "Tokenizer.hpp"
+#include <mutex>
+#include <string>
 
 Compiler::Compiler(IRGenerator& irGenerator) : m_irGenerator(irGenerator){
 
 }
 
+Compiler::Compiler(IRGenerator& irGenerator, const CompilerOptions& options)
+    : m_irGenerator(irGenerator), m_options(options){
+
+}
+
+template<typename Func>
+void Compiler::measure(const std::string& phase, Func func){
+    auto start = std::chrono::steady_clock::now();
+    func();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    for(auto& timing: m_timings){
+        if(timing.first == phase){
+            timing.second += elapsed.count();
+            return;
+        }
+    }
+    m_timings.emplace_back(phase, elapsed.count());
+}
+
+void Compiler::printTimings() const{
+    double total = 0;
+    std::cerr << "Phase timings (ms)" << std::endl;
+    for(const auto& timing: m_timings){
+        std::cerr << "  " << std::left << std::setw(20) << timing.first << std::fixed << std::setprecision(3) << timing.second << std::endl;
+        total += timing.second;
+    }
+    std::cerr << "  " << std::left << std::setw(20) << "total" << std::fixed << std::setprecision(3) << total << std::endl;
+    std::cerr << "Output size (bytes) " << m_outputSize << std::endl;
+}
+
+void Compiler::compile(const std::filesystem::path& srcFilepath){
+    if(!m_options.targetCpu.empty()){
+        m_irGenerator.setTargetCpu(m_options.targetCpu);
+    }
+    const std::filesystem::path extension = srcFilepath.extension();
+    if(extension == ".bc" || extension == ".ll"){
+        // previously emitted ir is consumed directly without going through frontend
+        measure("read ir", [&](){
+            m_irGenerator.loadFromFile(srcFilepath);
+        });
+    }else{
+        compileSourceFiles(srcFilepath);
+    }
+    if(m_options.lto){
+        measure("stdlib linking", [&](){
+            m_irGenerator.linkStandardLibrary(m_options.stdLibBitcodePath);
+        });
+    }
+    if(m_options.wholeProgram){
+        measure("internalize", [&](){
+            m_irGenerator.internalize();
+        });
+    }
+    m_irGenerator.setProfile(m_options.profileMode, m_options.profileFile);
+    measure("optimization", [&](){
+        m_irGenerator.optimize(m_options.optimizationLevel);
+    });
+}
+
 void Compiler::compileToIR(const std::filesystem::path& srcFilepath, const std::filesystem::path& outputFilepath){
+    compile(srcFilepath);
+    measure("write ir", [&](){
+        m_irGenerator.saveToFile(outputFilepath);
+    });
+}
 
-    ast::File syntaxTree = generateAST(srcFilepath);
-    performIRGeneration(syntaxTree, srcFilepath.filename().string());
-    m_irGenerator.saveToFile(outputFilepath);
-    syntaxTree.free();
+int Compiler::run(){
+    int exitCode = 0;
+    measure("jit execution", [&](){
+        exitCode = m_irGenerator.run();
+    });
+    return exitCode;
 }
 
-void Compiler::buildExec(const std::string& irFilePath, const std::string& outputfile,  Platform platform){
-    std::string tempObj = outputfile+".o";
-    std::string compileToObjCommand = "llc -filetype=obj "+irFilePath+" -o "+tempObj;
-    std::string linkCommand;
-    
-    if(platform == Platform::WIN){
-        linkCommand = "lld-link "+tempObj+" "+commonLibs+" "+winLibs+" -o "+outputfile;
-    }else if(platform == Platform::LINUX){
-        linkCommand = "ld.lld "+tempObj+" "+commonLibs+" "+linuxLibs+" -o "+outputfile;
+void Compiler::writeOutput(const std::string& outputfile, Platform platform){
+    if(m_options.outputType == OutputType::EXECUTABLE){
+        buildExec(outputfile, platform);
+    }else{
+        measure("write output", [&](){
+            switch(m_options.outputType){
+                case OutputType::LLVM_IR:
+                    m_irGenerator.saveToFile(outputfile);
+                    break;
+                case OutputType::BITCODE:
+                    m_irGenerator.saveBitcodeToFile(outputfile);
+                    break;
+                case OutputType::ASSEMBLY:
+                    m_irGenerator.emitAssembly(outputfile);
+                    break;
+                case OutputType::OBJECT:
+                    m_irGenerator.emitObject(std::filesystem::path(outputfile));
+                    break;
+                case OutputType::EXECUTABLE:
+                    break;
+            }
+        });
     }
-    system(compileToObjCommand.c_str());
-    system(linkCommand.c_str());
-    remove(tempObj.c_str());
+    std::error_code error;
+    m_outputSize = std::filesystem::file_size(outputfile, error);
 }
 
-ast::File Compiler::generateAST(const std::filesystem::path& srcFilepath){
+void Compiler::buildExec(const std::string& outputfile,  Platform platform){
+    if(platform != Platform::LINUX){
+        throw CompilationError("Linking is only supported for linux");
+    }
+    std::vector<std::vector<char>> objects;
+    measure("object emission", [&](){
+        m_irGenerator.emitObjects(objects, m_options.jobs);
+    });
+    Linker linker(m_options.stdLibPath);
+    if(m_options.profileMode == ProfileMode::GENERATE){
+        linker.requireSymbol("__llvm_profile_runtime");
+    }
+    std::string errorMsg;
+    bool isLinked = false;
+    measure("linking", [&](){
+        isLinked = linker.link(objects, outputfile, errorMsg);
+    });
+    if(!isLinked){
+        throw CompilationError("Linking failed : " + errorMsg);
+    }
+}
 
-    std::ifstream srcFile(srcFilepath.string());
+Compiler::SourceFile::SourceFile(const std::filesystem::path& path)
+    : path(path), stream(path), errorHandler(stream){
 
-    if(!srcFile){
-        std::cerr << "Could not open file : "+ srcFilepath.string() << std::endl;
+}
+
+Compiler::SourceFile::~SourceFile(){
+    syntaxTree.free();
+}
+
+/*
+    The import graph is discovered by parsing files as their imports are found, afterwards every
+    file is analyzed and lowered to its own module in parallel. Analysis only needs the function
+    signatures of imported files, so there is no ordering between files once all are parsed.
+*/
+void Compiler::compileSourceFiles(const std::filesystem::path& srcFilepath){
+    // source files and their syntax trees are dropped when compilation finishes or fails
+    struct SourceFilesGuard{
+        Compiler& compiler;
+        ~SourceFilesGuard(){
+            compiler.m_sourceFiles.clear();
+            compiler.m_sourceFileIndex.clear();
+        }
+    } sourceFilesGuard{*this};
+    ThreadPool threadPool(m_options.jobs);
+    bool isAdded;
+    SourceFile* mainFile = findOrAddSourceFile(srcFilepath, isAdded);
+
+    measure("parsing", [&](){
+        threadPool.submit([this, mainFile, &threadPool](){
+            parse(*mainFile, threadPool);
+        });
+        threadPool.wait();
+    });
+    measure("analysis", [&](){
+        for(SourceFile& sourceFile: m_sourceFiles){
+            threadPool.submit([this, file = &sourceFile](){
+                analyze(*file);
+            });
+        }
+        threadPool.wait();
+    });
+    measure("ir generation", [&](){
+        for(SourceFile& sourceFile: m_sourceFiles){
+            threadPool.submit([this, file = &sourceFile, isMainFile = (&sourceFile == mainFile)](){
+                generateIR(*file, isMainFile);
+            });
+        }
+        threadPool.wait();
+    });
+    measure("module linking", [&](){
+        for(SourceFile& sourceFile: m_sourceFiles){
+            if(&sourceFile != mainFile){
+                m_irGenerator.linkBitcode(sourceFile.bitcode, sourceFile.path.string());
+            }
+        }
+    });
+}
+
+Compiler::SourceFile* Compiler::findOrAddSourceFile(const std::filesystem::path& srcFilepath, bool& isAdded){
+    const std::string key = std::filesystem::absolute(srcFilepath).lexically_normal().string();
+    std::lock_guard<std::mutex> lock(m_sourceFilesMutex);
+    auto it = m_sourceFileIndex.find(key);
+    if(it != m_sourceFileIndex.end()){
+        isAdded = false;
+        return it->second;
     }
-    const ErrorHandler errorHandler(srcFile);
-    Tokenizer tokenizer(srcFile, errorHandler);
-    Parser parser(tokenizer, errorHandler);
-    ast::File syntaxTree = parser.evaluate();
-    Analyzer analyzer(syntaxTree, errorHandler);
-    analyzer.analyze();
-    return syntaxTree;
+    SourceFile* sourceFile = &m_sourceFiles.emplace_back(srcFilepath);
+    m_sourceFileIndex.insert({key, sourceFile});
+    isAdded = true;
+    return sourceFile;
 }
 
-void Compiler::performIRGeneration(const ast::File& file, const std::string& filename){
-    m_files.push_back(filename);
-    for(auto package: file.importPackages){
-        std::string packagePathStr(package->m_value, package->m_valueSize);
-        std::filesystem::path packagePath(packagePathStr);
-        std::string packageName = packagePath.filename().string();
+void Compiler::parse(SourceFile& sourceFile, ThreadPool& threadPool){
+    if(!sourceFile.stream){
+        throw CompilationError("Could not open file : "+ sourceFile.path.string());
+    }
+    Tokenizer tokenizer(sourceFile.stream, sourceFile.errorHandler);
+    Parser parser(tokenizer, sourceFile.errorHandler);
+    sourceFile.syntaxTree = parser.evaluate();
 
-        auto searchResult = std::find(m_files.begin(), m_files.end(), packageName);
-        if(searchResult != m_files.end()){
+    for(Token* package: sourceFile.syntaxTree.importPackages){
+        const std::filesystem::path packagePath(std::string(package->m_value, package->m_valueSize));
+        bool isAdded;
+        SourceFile* importedFile = findOrAddSourceFile(packagePath, isAdded);
+        if(isAdded){
+            threadPool.submit([this, importedFile, pool = &threadPool](){
+                parse(*importedFile, *pool);
+            });
+        }
+    }
+}
+
+void Compiler::analyze(SourceFile& sourceFile){
+    // parsing of every file has finished, imported function lists are only read from here on
+    for(Token* package: sourceFile.syntaxTree.importPackages){
+        const std::filesystem::path packagePath(std::string(package->m_value, package->m_valueSize));
+        bool isAdded;
+        SourceFile* importedFile = findOrAddSourceFile(packagePath, isAdded);
+        if(importedFile == &sourceFile){
             continue;
         }
-        ast::File syntaxTree = generateAST(packagePathStr);
-        performIRGeneration(syntaxTree, packageName);
+        for(ast::Function* function: importedFile->syntaxTree.functions){
+            sourceFile.importedFunctions.push_back(function);
+        }
+    }
+    Analyzer analyzer(sourceFile.syntaxTree, sourceFile.errorHandler, sourceFile.importedFunctions);
+    analyzer.analyze();
+}
+
+void Compiler::generateIR(SourceFile& sourceFile, bool isMainFile){
+    IRGenerator* irGenerator = &m_irGenerator;
+    if(!isMainFile){
+        sourceFile.irGenerator = m_irGenerator.createModuleGenerator(sourceFile.path.filename().string());
+        irGenerator = sourceFile.irGenerator.get();
+    }
+    if(m_options.debugInfo){
+        irGenerator->enableDebugInfo(sourceFile.path);
+    }
+    if(m_options.boundsChecks){
+        irGenerator->enableBoundsChecks();
     }
-    m_irGenerator.generate(file);
-}
\ No newline at end of file
+    irGenerator->setMemoCapacity(m_options.memoCapacity);
+    for(ast::Function* function: sourceFile.importedFunctions){
+        irGenerator->declare(*function);
+    }
+    irGenerator->generate(sourceFile.syntaxTree);
+    if(!isMainFile){
+        irGenerator->emitBitcode(sourceFile.bitcode);
+        sourceFile.irGenerator.reset();
+    }
+}
@@ -1,31 +1,103 @@
 #pragma once
 
+#include "ErrorHandler.hpp"
 #include "IRGenerator.hpp"
+#include "ThreadPool.hpp"
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <string>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef STDLIB_PATH
+#define STDLIB_PATH "libstdlinux.a"
+#endif
+
+#ifndef STDLIB_BITCODE_PATH
+#define STDLIB_BITCODE_PATH "stdlinux.bc"
+#endif
 
 enum class Platform{
     WIN,
     LINUX
 };
 
+enum class OutputType{
+    EXECUTABLE,
+    LLVM_IR,
+    BITCODE,
+    ASSEMBLY,
+    OBJECT
+};
+
+struct CompilerOptions{
+    OptimizationLevel optimizationLevel = OptimizationLevel::O0;
+    OutputType outputType = OutputType::EXECUTABLE;
+    bool printTimings = false;
+    bool runProgram = false;
+    // number of threads source files are compiled on
+    unsigned int jobs = 1;
+    bool wholeProgram = false;
+    bool debugInfo = false;
+    bool boundsChecks = false;
+    // bytes of the result table of each memo function
+    uint64_t memoCapacity = 1 << 20;
+    // empty keeps the generic cpu
+    std::string targetCpu;
+    ProfileMode profileMode = ProfileMode::NONE;
+    std::filesystem::path profileFile = "default.profraw";
+    // link the bitcode standard library into the program before optimization
+    bool lto = false;
+    std::filesystem::path stdLibPath = STDLIB_PATH;
+    std::filesystem::path stdLibBitcodePath = STDLIB_BITCODE_PATH;
+};
+
 class Compiler{
     
 public:
     Compiler(IRGenerator& irGenerator);
+    Compiler(IRGenerator& irGenerator, const CompilerOptions& options);
+    void compile(const std::filesystem::path& srcFilepath);
     void compileToIR(const std::filesystem::path& srcFilepath, const std::filesystem::path& outputIrFilepath);
-    void buildExec(const std::string& irFilePath, const std::string& outputfile,  Platform platform);
+    void buildExec(const std::string& outputfile,  Platform platform);
+    void writeOutput(const std::string& outputfile, Platform platform);
+    int run();
+    void printTimings() const;
 
 private:
-    void performIRGeneration(const ast::File& file, const std::string& filename);
-    ast::File generateAST(const std::filesystem::path& srcFilepath);
+    // a source file compiled as its own module, imported files are linked into the module of the main file
+    struct SourceFile{
+        SourceFile(const std::filesystem::path& path);
+        ~SourceFile();
+
+        const std::filesystem::path path;
+        std::ifstream stream;
+        const ErrorHandler errorHandler;
+        ast::File syntaxTree;
+        std::list<ast::Function*> importedFunctions;
+        std::unique_ptr<IRGenerator> irGenerator;
+        std::vector<char> bitcode;
+    };
 
-    const std::string commonLibs = "";
-    const std::string linuxLibs = "libstdlinux.a";
-    const std::string winLibs = "";
+    void compileSourceFiles(const std::filesystem::path& srcFilepath);
+    SourceFile* findOrAddSourceFile(const std::filesystem::path& srcFilepath, bool& isAdded);
+    void parse(SourceFile& sourceFile, ThreadPool& threadPool);
+    void analyze(SourceFile& sourceFile);
+    void generateIR(SourceFile& sourceFile, bool isMainFile);
+
+    template<typename Func>
+    void measure(const std::string& phase, Func func);
 
     IRGenerator& m_irGenerator;
-    std::list<std::string> m_files;
-};
\ No newline at end of file
+    CompilerOptions m_options;
+    std::list<SourceFile> m_sourceFiles;
+    std::unordered_map<std::string, SourceFile*> m_sourceFileIndex;
+    std::mutex m_sourceFilesMutex;
+    std::vector<std::pair<std::string, double>> m_timings;
+    std::uintmax_t m_outputSize = 0;
+};
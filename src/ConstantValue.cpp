@@ -0,0 +1,167 @@
+#include "ConstantValue.hpp"
+#include "AST.hpp"
+#include "Token.hpp"
+#include <limits>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace{
+
+template<typename T, typename UnsignedT>
+bool evaluateInteger(ast::Opcode opcode, T lhs, T rhs, T& result){
+    switch(opcode){
+        case ast::Opcode::ADDITION:
+            result = static_cast<T>(static_cast<UnsignedT>(lhs) + static_cast<UnsignedT>(rhs));
+            return true;
+        case ast::Opcode::SUBTRACTION:
+            result = static_cast<T>(static_cast<UnsignedT>(lhs) - static_cast<UnsignedT>(rhs));
+            return true;
+        case ast::Opcode::MULTIPLICATION:
+            result = static_cast<T>(static_cast<UnsignedT>(lhs) * static_cast<UnsignedT>(rhs));
+            return true;
+        case ast::Opcode::DIVISION:
+            // sdiv by zero or overflowing sdiv is left to runtime
+            if(rhs == 0 || (rhs == -1 && lhs == std::numeric_limits<T>::min())){
+                return false;
+            }
+            result = lhs / rhs;
+            return true;
+        default:
+            return false;
+    }
+}
+
+template<typename T>
+bool compareValues(ast::Opcode opcode, T lhs, T rhs, bool& result){
+    switch(opcode){
+        case ast::Opcode::GREATER_THAN:
+            result = lhs > rhs;
+            return true;
+        case ast::Opcode::SMALLER_THAN:
+            result = lhs < rhs;
+            return true;
+        case ast::Opcode::GREATER_OR_EQUAL:
+            result = lhs >= rhs;
+            return true;
+        case ast::Opcode::SMALLER_OR_EQUAL:
+            result = lhs <= rhs;
+            return true;
+        case ast::Opcode::EQUAL_TO:
+            result = lhs == rhs;
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool evaluateFloat(ast::Opcode opcode, float lhs, float rhs, float& result){
+    switch(opcode){
+        case ast::Opcode::ADDITION:
+            result = lhs + rhs;
+            return true;
+        case ast::Opcode::SUBTRACTION:
+            result = lhs - rhs;
+            return true;
+        case ast::Opcode::MULTIPLICATION:
+            result = lhs * rhs;
+            return true;
+        case ast::Opcode::DIVISION:
+            result = lhs / rhs;
+            return true;
+        default:
+            return false;
+    }
+}
+
+}
+
+bool constant::fromLiteral(const Token& literal, ConstantValue& value){
+    if(literal.m_tokenType.type == Type::STRING_LITERAL){
+        if(literal.m_valueSize != 1){
+            return false;
+        }
+        value.dataType = Keyword::CHAR;
+        value.charValue = literal.m_value[0];
+        return true;
+    }else if(literal.m_tokenType.type == Type::NUMERIC_LITERAL){
+        std::string text(literal.m_value, literal.m_valueSize);
+        if(literal.m_tokenType.isFloatingPointValue){
+            value.dataType = Keyword::FLOAT;
+            value.floatValue = std::stof(text);
+        }else{
+            value.dataType = Keyword::INT;
+            value.intValue = std::stoi(text);
+        }
+        return true;
+    }
+    return false;
+}
+
+Token* constant::createLiteral(const ConstantValue& value, uint32_t lineNumber){
+    if(value.dataType == Keyword::CHAR){
+        char* data = new char[1]{value.charValue};
+        return new Token(TokenType(Type::STRING_LITERAL), data, 1, lineNumber);
+    }
+    char text[32];
+    int length;
+    if(value.dataType == Keyword::FLOAT){
+        // 9 significant digits are enough to round trip a float
+        length = std::snprintf(text, sizeof(text), "%.9g", value.floatValue);
+    }else{
+        length = std::snprintf(text, sizeof(text), "%d", value.intValue);
+    }
+    char* data = new char[length];
+    for(int i=0;i<length;i++){
+        data[i] = text[i];
+    }
+    Token* literal = new Token(TokenType(Type::NUMERIC_LITERAL), data, static_cast<uint16_t>(length), lineNumber);
+    literal->m_tokenType.isFloatingPointValue = (value.dataType == Keyword::FLOAT);
+    return literal;
+}
+
+bool constant::evaluate(ast::Opcode opcode, const ConstantValue& lhs, const ConstantValue& rhs, ConstantValue& result){
+    if(lhs.dataType != rhs.dataType){
+        return false;
+    }
+    ConstantValue value;
+    value.dataType = lhs.dataType;
+    bool isEvaluated = false;
+    switch(lhs.dataType){
+        case Keyword::INT:
+            isEvaluated = evaluateInteger<int32_t, uint32_t>(opcode, lhs.intValue, rhs.intValue, value.intValue);
+            break;
+        case Keyword::CHAR:
+            {
+                int8_t charResult;
+                isEvaluated = evaluateInteger<int8_t, uint8_t>(opcode, lhs.charValue, rhs.charValue, charResult);
+                value.charValue = static_cast<char>(charResult);
+            }
+            break;
+        case Keyword::FLOAT:
+            isEvaluated = evaluateFloat(opcode, lhs.floatValue, rhs.floatValue, value.floatValue);
+            break;
+        default:
+            break;
+    }
+    if(isEvaluated){
+        result = value;
+    }
+    return isEvaluated;
+}
+
+bool constant::compare(ast::Opcode opcode, const ConstantValue& lhs, const ConstantValue& rhs, bool& result){
+    if(lhs.dataType != rhs.dataType){
+        return false;
+    }
+    switch(lhs.dataType){
+        case Keyword::INT:
+            return compareValues(opcode, lhs.intValue, rhs.intValue, result);
+        case Keyword::CHAR:
+            return compareValues(opcode, static_cast<int8_t>(lhs.charValue), static_cast<int8_t>(rhs.charValue), result);
+        case Keyword::FLOAT:
+            return compareValues(opcode, lhs.floatValue, rhs.floatValue, result);
+        default:
+            return false;
+    }
+}
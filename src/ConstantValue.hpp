@@ -0,0 +1,35 @@
+#pragma once
+#include "AST.hpp"
+#include "Token.hpp"
+#include <cstdint>
+
+struct ConstantValue{
+    Keyword dataType = Keyword::NIL;
+
+    union{
+        int32_t intValue = 0;
+        float floatValue;
+        char charValue;
+    };
+};
+
+namespace constant{
+
+    /*
+        Reads the value of a numeric or char literal token.
+        Returns false if token is not a literal.
+    */
+    bool fromLiteral(const Token& literal, ConstantValue& value);
+
+    // Creates a new literal token holding the given value.
+    Token* createLiteral(const ConstantValue& value, uint32_t lineNumber);
+
+    /*
+        Applies arithmetic opcode on lhs and rhs with the same wrapping behaviour as generated code.
+        Returns false (and leaves result untouched) when the operation cannot be folded eg: division by zero.
+    */
+    bool evaluate(ast::Opcode opcode, const ConstantValue& lhs, const ConstantValue& rhs, ConstantValue& result);
+
+    // Applies relational opcode on lhs and rhs. Returns false if opcode is not relational.
+    bool compare(ast::Opcode opcode, const ConstantValue& lhs, const ConstantValue& rhs, bool& result);
+};
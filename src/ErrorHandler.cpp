@@ -1,7 +1,5 @@
 #include "ErrorHandler.hpp"
-#include <cstdlib>
 #include <fstream>
-#include <iostream>
 #include <string>
 
 ErrorHandler::ErrorHandler(std::ifstream& currentFile)
@@ -10,8 +8,7 @@ ErrorHandler::ErrorHandler(std::ifstream& currentFile)
 }
 
 void ErrorHandler::reportError(const std::string& errorMsg) const{
-    std::cerr << errorMsg << std::endl;
-    std::exit(EXIT_FAILURE);
+    throw CompilationError(errorMsg);
 }
 
 void ErrorHandler::reportError(const std::string& errorMsg, const int lineNum) const{
@@ -57,8 +54,7 @@ void ErrorHandler::reportError(const std::string& errorMsg, const int lineNum) c
     }
     text += "\n\n\n"+errorMsg+"\n";
 
-    std::cerr << text << std::endl;
-    std::exit(EXIT_FAILURE);
+    throw CompilationError(text);
 }
 
 void ErrorHandler::reportError(const std::string& errorMsg, const Token& token) const{
@@ -2,8 +2,16 @@
 #include "Token.hpp"
 #include <fstream>
 #include "AST.hpp"
+#include <stdexcept>
 #include <system_error>
 
+// Thrown for any error that stops the compilation, the message is ready to be shown to the user.
+class CompilationError : public std::runtime_error{
+
+public:
+    using std::runtime_error::runtime_error;
+};
+
 class ErrorHandler{
 
 public:
@@ -34,6 +42,27 @@ namespace error{
     constexpr const char* EXPECTED_RETURN = "Expected return statement at the end of function";
     constexpr const char* MAIN_FUNC_RET = "Main function should return int";
     constexpr const char* INV_TOKEN = "Invalid token";
+    constexpr const char* CONST_NOT_INITIALIZED = "Const variable must be initialized.";
+    constexpr const char* CONST_ASSIGNMENT = "Cannot assign to const variable.";
+    constexpr const char* INVALID_ARRAY_SIZE = "Array size must be a positive integer literal.";
+    constexpr const char* ARRAY_INITIALIZED = "Array can only be initialized with a list of elements eg: int a[3] = {1, 2, 3};";
+    constexpr const char* ARRAY_AS_VALUE = "Array can only be indexed or passed to a function.";
+    constexpr const char* NOT_AN_ARRAY = "Variable is not an array.";
+    constexpr const char* INDEX_OUT_OF_BOUNDS = "Array index is out of bounds.";
+    constexpr const char* ARRAY_PASSED_TWICE = "Same array cannot be passed to more than one parameter of a call.";
+    constexpr const char* VECTOR_COMPARISON = "Vectors cannot be compared or used as a condition, compare their lanes instead.";
+    constexpr const char* NOT_A_VECTOR = "Reduction expects a single vector argument.";
+    constexpr const char* PARALLEL_LOOP_FORM = "Parallel loop must be of the form while(i < n) parallel { ... i = i + 1; } with an int counter i.";
+    constexpr const char* PARALLEL_SHARED_ASSIGNMENT = "Parallel loop can only assign to its own variables and to array elements.";
+    constexpr const char* PARALLEL_ARRAY_INDEX = "Parallel loop can only write shared arrays, and read the arrays it writes, at the loop counter eg: a[i].";
+    constexpr const char* PARALLEL_ARRAY_ARGUMENT = "Shared arrays cannot be passed to a function inside a parallel loop.";
+    constexpr const char* PARALLEL_GLOBAL_WRITE = "Functions that write globals, directly or through the functions they call, cannot be called inside a parallel loop.";
+    constexpr const char* PARALLEL_RETURN = "Cannot return from a parallel loop.";
+    constexpr const char* GLOBAL_NOT_CONSTANT = "Global can only be initialized with values known at compile time.";
+    constexpr const char* TOO_MANY_ELEMENTS = "Array initializer has more elements than the array.";
+    constexpr const char* CONST_ARRAY_ARGUMENT = "Const array cannot be passed to a function.";
+    constexpr const char* MEMO_SIGNATURE = "Memo function can only take int and char parameters and must return int, char or float.";
+    constexpr const char* MEMO_NOT_PURE = "Memo function cannot use globals, write to arrays or call functions with side effects.";
     constexpr const char* LOGICAL_ERR = "Expected boolean expression in either side of Logical operator";
 };
 
@@ -1,11 +1,13 @@
 #include "IRGenerator.hpp"
 #include "AST.hpp"
+#include "ConstantValue.hpp"
 #include "ErrorHandler.hpp"
 #include "Token.hpp"
 #include <cstdlib>
 #include <filesystem>
 #include <iostream>
 #include <llvm/ADT/StringRef.h>
+#include <llvm/ADT/StringSet.h>
 #include <llvm/IR/Argument.h>
 #include <string>
 #include <llvm/ADT/ArrayRef.h>
@@ -17,16 +19,166 @@
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/Value.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/ExecutionEngine/JITSymbol.h>
+#include <llvm/ExecutionEngine/Orc/Core.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/CodeGen/ParallelCG.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/MC/MCSubtargetInfo.h>
+#include <llvm/MC/SubtargetFeature.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/CodeGen.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/ProfileData/InstrProf.h>
+#include <llvm/ProfileData/InstrProfReader.h>
+#include <llvm/ProfileData/InstrProfWriter.h>
+#include <llvm/Transforms/IPO/FunctionAttrs.h>
+#include <llvm/Transforms/IPO/GlobalDCE.h>
+#include <llvm/Transforms/IPO/InferFunctionAttrs.h>
+#include <llvm/Transforms/IPO/Internalize.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/IR/LLVMContext.h>
+#include <algorithm>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_set>
+#include <utility>
 
-std::unique_ptr<llvm::LLVMContext> LlvmIRGenerator::llvmContext;
-llvm::Type* LlvmIRGenerator::intType;
-llvm::Type* LlvmIRGenerator::charType;
-llvm::Type* LlvmIRGenerator::floatType;
-llvm::Type* LlvmIRGenerator::voidType;
+extern "C"{
+#include "StandardLibrary/console_io.h"
+#include "StandardLibrary/parallel.h"
+}
+
+namespace{
+
+// standard library functions of the compiler process itself, bound to jit compiled programs
+const std::pair<const char*, llvm::JITTargetAddress> hostStandardLibFunctions[] = {
+    {"printChar", llvm::pointerToJITTargetAddress(&printChar)},
+    {"printlnChar", llvm::pointerToJITTargetAddress(&printlnChar)},
+    {"printInt", llvm::pointerToJITTargetAddress(&printInt)},
+    {"printlnInt", llvm::pointerToJITTargetAddress(&printlnInt)},
+    {"getNextInt", llvm::pointerToJITTargetAddress(&getNextInt)},
+    {"getNextChar", llvm::pointerToJITTargetAddress(&getNextChar)},
+    {"parallelFor", llvm::pointerToJITTargetAddress(&parallelFor)}
+};
+
+// line of the first token in expression, 0 if it has none
+uint32_t findLineNumber(const ast::Expression& expression){
+    const ast::Factor& factor = *expression.m_relational->m_additive->m_term->m_factor;
+    switch(factor.operandType){
+        case ast::Factor::OperandType::VALUE:
+            return factor.operand.value->m_lineNumber;
+        case ast::Factor::OperandType::EXPR:
+            return findLineNumber(*factor.operand.expression);
+        case ast::Factor::OperandType::FUNCTION_CALL:
+            return factor.operand.functionCall->m_identifier->m_lineNumber;
+        case ast::Factor::OperandType::ARRAY_ACCESS:
+            return factor.operand.arrayAccess->m_identifier->m_lineNumber;
+    }
+    return 0;
+}
+
+uint32_t findLineNumber(const ast::Statement& statement){
+    switch(statement.m_type){
+        case ast::Statement::Type::DECLARATIVE:
+            return statement.m_data.declarativeStatement->m_identifier->m_lineNumber;
+        case ast::Statement::Type::ASSIGNMENT:
+            return statement.m_data.assignmentStatement->m_identifier->m_lineNumber;
+        case ast::Statement::Type::CONDITIONAL:
+            return findLineNumber(*statement.m_data.conditionalStatement->m_expr);
+        case ast::Statement::Type::FUNCTION_CALL:
+            return statement.m_data.functionalCallStatement->m_identifier->m_lineNumber;
+        case ast::Statement::Type::RETURN:
+            {
+                const ast::Expression* expression = statement.m_data.returnStatement->m_expr;
+                return expression != nullptr ? findLineNumber(*expression) : 0;
+            }
+        case ast::Statement::Type::WHILE_LOOP:
+            return findLineNumber(*statement.m_data.whileLoop->m_expr);
+    }
+    return 0;
+}
+
+// returns the call when the whole expression is a single function call eg: return f(x);
+ast::FunctionCallStatement* findTailCall(ast::Expression& expression){
+    if(expression.m_expressionTail != nullptr){
+        return nullptr;
+    }
+    ast::Relational& relational = *expression.m_relational;
+    if(relational.m_relationalTail != nullptr || relational.m_additive->m_additiveTail != nullptr){
+        return nullptr;
+    }
+    ast::Term& term = *relational.m_additive->m_term;
+    if(term.m_termTail != nullptr){
+        return nullptr;
+    }
+    ast::Factor& factor = *term.m_factor;
+    if(factor.operandType == ast::Factor::OperandType::EXPR){
+        return findTailCall(*factor.operand.expression);
+    }
+    if(factor.operandType == ast::Factor::OperandType::FUNCTION_CALL){
+        return factor.operand.functionCall;
+    }
+    return nullptr;
+}
+
+// returns the token of an additive made of a single variable or literal
+const Token* findSingleValue(const ast::Additive& additive){
+    if(additive.m_additiveTail != nullptr || additive.m_term->m_termTail != nullptr){
+        return nullptr;
+    }
+    const ast::Factor& factor = *additive.m_term->m_factor;
+    if(factor.operandType != ast::Factor::OperandType::VALUE){
+        return nullptr;
+    }
+    return factor.operand.value;
+}
+
+// matches conditions of the form variable == literal or literal == variable
+bool findEqualityTest(const ast::Expression& expression, const Token*& variable, ConstantValue& value){
+    if(expression.m_expressionTail != nullptr){
+        return false;
+    }
+    const ast::Relational& relational = *expression.m_relational;
+    const ast::RelationalTail* relationalTail = relational.m_relationalTail;
+    if(relationalTail == nullptr || relationalTail->m_relationalTail != nullptr || relationalTail->m_opcode != ast::Opcode::EQUAL_TO){
+        return false;
+    }
+    const Token* lhs = findSingleValue(*relational.m_additive);
+    const Token* rhs = findSingleValue(*relationalTail->m_additive);
+    if(lhs == nullptr || rhs == nullptr){
+        return false;
+    }
+    if(rhs->m_tokenType == Type::IDENTIFIER){
+        std::swap(lhs, rhs);
+    }
+    variable = lhs;
+    return lhs->m_tokenType == Type::IDENTIFIER && constant::fromLiteral(*rhs, value);
+}
+
+void throwOnError(llvm::Error error){
+    if(error){
+        throw CompilationError(llvm::toString(std::move(error)));
+    }
+}
+
+}
 
 LlvmIRGenerator::LlvmIRGenerator(const std::string& moduleName){
     init(moduleName);
@@ -34,17 +186,38 @@ LlvmIRGenerator::LlvmIRGenerator(const std::string& moduleName){
 }
 
 void LlvmIRGenerator::init(const std::string& moduleName){
-    static bool isInitialized = false;
-    if(!isInitialized){
-        llvmContext = std::make_unique<llvm::LLVMContext>();
-        intType = llvm::Type::getInt32Ty(*llvmContext);
-        charType = llvm::Type::getInt8Ty(*llvmContext);
-        floatType = llvm::Type::getFloatTy(*llvmContext);
-        voidType = llvm::Type::getVoidTy(*llvmContext);
-        isInitialized = true;
+    m_llvmContext = std::make_unique<llvm::LLVMContext>();
+    m_intType = llvm::Type::getInt32Ty(*m_llvmContext);
+    m_charType = llvm::Type::getInt8Ty(*m_llvmContext);
+    m_floatType = llvm::Type::getFloatTy(*m_llvmContext);
+    m_voidType = llvm::Type::getVoidTy(*m_llvmContext);
+    m_module =  std::make_unique<llvm::Module>(moduleName, *m_llvmContext);
+    m_IRBuilder = std::make_unique<llvm::IRBuilder<>>(*m_llvmContext);
+    initTargetMachine();
+}
+
+void LlvmIRGenerator::initTargetMachine(const std::string& cpu, const std::string& features){
+    // target registration is process wide, every other llvm object is owned by this generator
+    static std::once_flag isTargetInitialized;
+    std::call_once(isTargetInitialized, [](){
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        // inline asm of the bitcode standard library is parsed during code generation
+        llvm::InitializeNativeTargetAsmParser();
+    });
+    const std::string targetTriple = llvm::sys::getDefaultTargetTriple();
+    std::string error;
+    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
+    if(target == nullptr){
+        throw CompilationError("Could not find target " + targetTriple + " : " + error);
     }
-    m_module =  std::make_unique<llvm::Module>(moduleName, *llvmContext);
-    m_IRBuilder = std::make_unique<llvm::IRBuilder<>>(*llvmContext);
+    llvm::TargetOptions targetOptions;
+    m_targetMachine.reset(target->createTargetMachine(targetTriple, cpu, features, targetOptions,
+            llvm::None, llvm::None, llvm::CodeGenOpt::None));
+
+    // data layout is needed before optimization so that passes see the real type sizes
+    m_module->setTargetTriple(targetTriple);
+    m_module->setDataLayout(m_targetMachine->createDataLayout());
 }
 
 void LlvmIRGenerator::includeStandardLibFuncPrototype(){
@@ -61,21 +234,471 @@ void LlvmIRGenerator::includeStandardLibFuncPrototype(){
     }
 }
 
+void LlvmIRGenerator::loadFromFile(const std::filesystem::path& inputFile){
+    llvm::SMDiagnostic diagnostic;
+    std::unique_ptr<llvm::Module> module = llvm::parseIRFile(inputFile.string(), diagnostic, *m_llvmContext);
+    if(module == nullptr){
+        std::string errorMsg;
+        llvm::raw_string_ostream errorStream(errorMsg);
+        diagnostic.print(inputFile.string().c_str(), errorStream);
+        throw CompilationError(errorStream.str());
+    }
+    m_module = std::move(module);
+    m_module->setTargetTriple(m_targetMachine->getTargetTriple().str());
+    m_module->setDataLayout(m_targetMachine->createDataLayout());
+}
+
 void LlvmIRGenerator::saveToFile(const std::filesystem::path& outputFile){
 
     std::error_code error;
     llvm::raw_fd_ostream output(outputFile.string(), error);
     m_module->print(output, nullptr);
     if(error){
-        std::cerr << "Could not open file : "+ outputFile.string() << std::endl;
-        std::exit(EXIT_FAILURE);
+        throw CompilationError("Could not open file : "+ outputFile.string());
+    }
+}
+
+void LlvmIRGenerator::saveBitcodeToFile(const std::filesystem::path& outputFile){
+    std::error_code error;
+    llvm::raw_fd_ostream output(outputFile.string(), error);
+    if(error){
+        throw CompilationError("Could not open file : "+ outputFile.string());
+    }
+    llvm::WriteBitcodeToFile(*m_module, output);
+    output.flush();
+    if(output.has_error()){
+        // an unhandled error would abort in the stream destructor
+        output.clear_error();
+        throw CompilationError("Could not write file : "+ outputFile.string());
+    }
+}
+
+void LlvmIRGenerator::emitAssembly(const std::filesystem::path& outputFile){
+    emitFile(outputFile, llvm::CGFT_AssemblyFile);
+}
+
+void LlvmIRGenerator::emitObject(const std::filesystem::path& outputFile){
+    emitFile(outputFile, llvm::CGFT_ObjectFile);
+}
+
+void LlvmIRGenerator::emitObject(std::vector<char>& buffer){
+    llvm::SmallVector<char, 0> objectBuffer;
+    llvm::raw_svector_ostream output(objectBuffer);
+    emitFile(output, llvm::CGFT_ObjectFile);
+    buffer.assign(objectBuffer.begin(), objectBuffer.end());
+}
+
+/*
+    Functions are partitioned with SplitModule, each partition is moved to its own context through
+    bitcode and code generated on its own thread.
+*/
+void LlvmIRGenerator::emitObjects(std::vector<std::vector<char>>& buffers, unsigned int partitionCount){
+    if(partitionCount == 0){
+        partitionCount = 1;
+    }
+    size_t functionCount = 0;
+    for(const llvm::Function& function: *m_module){
+        if(!function.isDeclaration()){
+            functionCount++;
+        }
+    }
+    // no point in a partition without any function in it
+    partitionCount = std::max<size_t>(1, std::min<size_t>(partitionCount, functionCount));
+
+    std::vector<llvm::SmallVector<char, 0>> objectBuffers(partitionCount);
+    std::vector<std::unique_ptr<llvm::raw_svector_ostream>> outputs;
+    std::vector<llvm::raw_pwrite_stream*> outputPtrs;
+    for(llvm::SmallVector<char, 0>& objectBuffer: objectBuffers){
+        outputs.push_back(std::make_unique<llvm::raw_svector_ostream>(objectBuffer));
+        outputPtrs.push_back(outputs.back().get());
+    }
+    llvm::splitCodeGen(*m_module, outputPtrs, {}, [this](){
+        return cloneTargetMachine();
+    }, llvm::CGFT_ObjectFile);
+
+    buffers.clear();
+    for(const llvm::SmallVector<char, 0>& objectBuffer: objectBuffers){
+        buffers.emplace_back(objectBuffer.begin(), objectBuffer.end());
+    }
+}
+
+std::unique_ptr<llvm::TargetMachine> LlvmIRGenerator::cloneTargetMachine() const{
+    const llvm::Target& target = m_targetMachine->getTarget();
+    return std::unique_ptr<llvm::TargetMachine>(target.createTargetMachine(m_targetMachine->getTargetTriple().str(),
+            m_targetMachine->getTargetCPU(), m_targetMachine->getTargetFeatureString(), m_targetMachine->Options,
+            m_targetMachine->getRelocationModel(), m_targetMachine->getCodeModel(), m_targetMachine->getOptLevel()));
+}
+
+void LlvmIRGenerator::emitFile(const std::filesystem::path& outputFile, llvm::CodeGenFileType fileType){
+    std::error_code error;
+    llvm::raw_fd_ostream output(outputFile.string(), error);
+    if(error){
+        throw CompilationError("Could not open file : "+ outputFile.string());
+    }
+    emitFile(output, fileType);
+    output.flush();
+    if(output.has_error()){
+        output.clear_error();
+        throw CompilationError("Could not write file : "+ outputFile.string());
     }
 }
 
+void LlvmIRGenerator::emitFile(llvm::raw_pwrite_stream& output, llvm::CodeGenFileType fileType){
+    llvm::legacy::PassManager passManager;
+    if(m_targetMachine->addPassesToEmitFile(passManager, output, nullptr, fileType)){
+        throw CompilationError("Target machine cannot emit file of given type");
+    }
+    passManager.run(*m_module);
+}
+
+int LlvmIRGenerator::run(){
+    llvm::Expected<llvm::orc::JITTargetMachineBuilder> targetMachineBuilder = llvm::orc::JITTargetMachineBuilder::detectHost();
+    throwOnError(targetMachineBuilder.takeError());
+    targetMachineBuilder->setCodeGenOptLevel(m_targetMachine->getOptLevel());
+
+    llvm::Expected<std::unique_ptr<llvm::orc::LLJIT>> jit = llvm::orc::LLJITBuilder()
+            .setJITTargetMachineBuilder(std::move(*targetMachineBuilder))
+            .create();
+    throwOnError(jit.takeError());
+
+    llvm::orc::SymbolMap hostSymbols;
+    for(const auto& function: hostStandardLibFunctions){
+        const llvm::Function* definition = m_module->getFunction(function.first);
+        if(definition != nullptr && !definition->isDeclaration()){
+            continue;
+        }
+        hostSymbols[(*jit)->mangleAndIntern(function.first)] = llvm::JITEvaluatedSymbol(function.second, llvm::JITSymbolFlags::Exported);
+    }
+    throwOnError((*jit)->getMainJITDylib().define(llvm::orc::absoluteSymbols(std::move(hostSymbols))));
+    throwOnError((*jit)->addIRModule(llvm::orc::ThreadSafeModule(std::move(m_module), std::move(m_llvmContext))));
+
+    llvm::Expected<llvm::JITEvaluatedSymbol> mainSymbol = (*jit)->lookup("main");
+    throwOnError(mainSymbol.takeError());
+    auto mainFunction = llvm::jitTargetAddressToFunction<int(*)()>(mainSymbol->getAddress());
+    return mainFunction();
+}
+
+void LlvmIRGenerator::optimize(OptimizationLevel optimizationLevel){
+    switch(optimizationLevel){
+        case OptimizationLevel::O0:
+            m_targetMachine->setOptLevel(llvm::CodeGenOpt::None);
+            // instrumentation is still needed at O0, profile use is not
+            if(m_profileMode != ProfileMode::GENERATE){
+                return;
+            }
+            break;
+        case OptimizationLevel::O1:
+            m_targetMachine->setOptLevel(llvm::CodeGenOpt::Less);
+            break;
+        case OptimizationLevel::O2:
+            m_targetMachine->setOptLevel(llvm::CodeGenOpt::Default);
+            break;
+        case OptimizationLevel::O3:
+            m_targetMachine->setOptLevel(llvm::CodeGenOpt::Aggressive);
+            break;
+    }
+    std::string verifierMsg;
+    llvm::raw_string_ostream verifierStream(verifierMsg);
+    if(llvm::verifyModule(*m_module, &verifierStream)){
+        throw CompilationError("Generated module is invalid, cannot optimize\n" + verifierStream.str());
+    }
+    llvm::OptimizationLevel level = llvm::OptimizationLevel::O1;
+    if(optimizationLevel == OptimizationLevel::O0){
+        level = llvm::OptimizationLevel::O0;
+    }else if(optimizationLevel == OptimizationLevel::O2){
+        level = llvm::OptimizationLevel::O2;
+    }else if(optimizationLevel == OptimizationLevel::O3){
+        level = llvm::OptimizationLevel::O3;
+    }
+
+    runPipeline([level](llvm::PassBuilder& passBuilder){
+        // the default pipeline is only meant for optimizing levels, O0 has its own with just the instrumentation
+        if(level == llvm::OptimizationLevel::O0){
+            return passBuilder.buildO0DefaultPipeline(level, /*LTOPreLink*/false);
+        }
+        return passBuilder.buildPerModuleDefaultPipeline(level);
+    }, createPGOOptions());
+}
+
+// programs built with --profile-generate write their profile with the stdlib runtime (StandardLibrary/linux/profile.c),
+// which only knows the layout of this raw profile version
+static_assert(INSTR_PROF_RAW_VERSION == 8, "the stdlib profile runtime writes raw profile version 8");
+
+void LlvmIRGenerator::setProfile(ProfileMode profileMode, const std::filesystem::path& profileFile){
+    m_profileMode = profileMode;
+    m_profileFile = profileFile;
+}
+
+llvm::Optional<llvm::PGOOptions> LlvmIRGenerator::createPGOOptions(){
+    if(m_profileMode == ProfileMode::GENERATE){
+        // the file name is stored in the program and used by the stdlib profile runtime
+        return llvm::PGOOptions(m_profileFile.string(), "", "", llvm::PGOOptions::IRInstr);
+    }
+    if(m_profileMode != ProfileMode::USE){
+        return llvm::None;
+    }
+    if(!std::filesystem::exists(m_profileFile)){
+        throw CompilationError("Could not find profile : " + m_profileFile.string());
+    }
+    if(m_profileFile.extension() != ".profraw"){
+        return llvm::PGOOptions(m_profileFile.string(), "", "", llvm::PGOOptions::IRUse);
+    }
+    // the optimizer only reads indexed profiles, raw profiles written by the program are converted first
+    llvm::Expected<std::unique_ptr<llvm::InstrProfReader>> reader = llvm::InstrProfReader::create(m_profileFile.string());
+    throwOnError(reader.takeError());
+    llvm::InstrProfWriter writer;
+    throwOnError(writer.mergeProfileKind((*reader)->getProfileKind()));
+    for(llvm::NamedInstrProfRecord& record: **reader){
+        writer.addRecord(std::move(record), [](llvm::Error error){
+            throwOnError(std::move(error));
+        });
+    }
+    throwOnError((*reader)->getError());
+
+    std::filesystem::path indexedProfile = m_profileFile;
+    indexedProfile.replace_extension(".profdata");
+    std::error_code error;
+    llvm::raw_fd_ostream output(indexedProfile.string(), error);
+    if(error){
+        throw CompilationError("Could not open file : "+ indexedProfile.string());
+    }
+    throwOnError(writer.write(output));
+    return llvm::PGOOptions(indexedProfile.string(), "", "", llvm::PGOOptions::IRUse);
+}
+
+void LlvmIRGenerator::linkStandardLibrary(const std::filesystem::path& bitcodeFile){
+    llvm::SMDiagnostic diagnostic;
+    std::unique_ptr<llvm::Module> standardLibrary = llvm::parseIRFile(bitcodeFile.string(), diagnostic, *m_llvmContext);
+    if(standardLibrary == nullptr){
+        std::string errorMsg;
+        llvm::raw_string_ostream errorStream(errorMsg);
+        diagnostic.print(bitcodeFile.string().c_str(), errorStream);
+        throw CompilationError(errorStream.str());
+    }
+    // cpu specific attributes from the c compiler would keep the functions from being inlined into ours
+    for(llvm::Function& function: *standardLibrary){
+        function.removeFnAttr("target-cpu");
+        function.removeFnAttr("target-features");
+        function.removeFnAttr("tune-cpu");
+    }
+    standardLibrary->setTargetTriple(m_module->getTargetTriple());
+    standardLibrary->setDataLayout(m_module->getDataLayout());
+
+    // only what the program calls is linked and it becomes internal, main is the only entry point
+    auto internalizeLinked = [](llvm::Module& module, const llvm::StringSet<>& linkedNames){
+        llvm::internalizeModule(module, [&linkedNames](const llvm::GlobalValue& globalValue){
+            return !globalValue.hasName() || linkedNames.count(globalValue.getName()) == 0;
+        });
+    };
+    if(llvm::Linker::linkModules(*m_module, std::move(standardLibrary), llvm::Linker::Flags::LinkOnlyNeeded, internalizeLinked)){
+        throw CompilationError("Could not link standard library : " + bitcodeFile.string());
+    }
+}
+
+/*
+    Programs are always linked as a whole against the standard library, so nothing but main can be
+    referenced from outside of the module. Internal functions can be inlined, specialized and removed
+    freely, and since the language has no exceptions every function is nounwind.
+*/
+void LlvmIRGenerator::internalize(){
+    for(llvm::Function& function: *m_module){
+        function.addFnAttr(llvm::Attribute::NoUnwind);
+    }
+    runPipeline([](llvm::PassBuilder& passBuilder){
+        llvm::ModulePassManager modulePassManager;
+        modulePassManager.addPass(llvm::InternalizePass([](const llvm::GlobalValue& globalValue){
+            return globalValue.getName() == "main";
+        }));
+        modulePassManager.addPass(llvm::InferFunctionAttrsPass());
+        modulePassManager.addPass(llvm::createModuleToPostOrderCGSCCPassAdaptor(llvm::PostOrderFunctionAttrsPass()));
+        modulePassManager.addPass(llvm::ReversePostOrderFunctionAttrsPass());
+        modulePassManager.addPass(llvm::GlobalDCEPass());
+        return modulePassManager;
+    });
+}
+
+void LlvmIRGenerator::runPipeline(const std::function<llvm::ModulePassManager(llvm::PassBuilder&)>& buildPipeline,
+        llvm::Optional<llvm::PGOOptions> pgoOptions){
+    llvm::LoopAnalysisManager loopAnalysisManager;
+    llvm::FunctionAnalysisManager functionAnalysisManager;
+    llvm::CGSCCAnalysisManager cgsccAnalysisManager;
+    llvm::ModuleAnalysisManager moduleAnalysisManager;
+    llvm::PassBuilder passBuilder(m_targetMachine.get(), llvm::PipelineTuningOptions(), pgoOptions);
+
+    passBuilder.registerModuleAnalyses(moduleAnalysisManager);
+    passBuilder.registerCGSCCAnalyses(cgsccAnalysisManager);
+    passBuilder.registerFunctionAnalyses(functionAnalysisManager);
+    passBuilder.registerLoopAnalyses(loopAnalysisManager);
+    passBuilder.crossRegisterProxies(loopAnalysisManager, functionAnalysisManager, cgsccAnalysisManager, moduleAnalysisManager);
+
+    llvm::ModulePassManager modulePassManager = buildPipeline(passBuilder);
+    modulePassManager.run(*m_module, moduleAnalysisManager);
+}
+
 void LlvmIRGenerator::generate(const ast::File& syntaxTree){
+    for(ast::DeclarativeStatement* global: syntaxTree.globals){
+        genGlobal(*global);
+    }
     for(ast::Function* function: syntaxTree.functions){
         genFunction(*function);
     }
+    m_globals.clear();
+    if(m_debugBuilder != nullptr){
+        m_debugBuilder->finalize();
+    }
+}
+
+void LlvmIRGenerator::enableDebugInfo(const std::filesystem::path& sourceFile){
+    m_debugBuilder = std::make_unique<llvm::DIBuilder>(*m_module);
+    const std::filesystem::path absolutePath = std::filesystem::absolute(sourceFile);
+    m_debugFile = m_debugBuilder->createFile(absolutePath.filename().string(), absolutePath.parent_path().string());
+    m_debugBuilder->createCompileUnit(llvm::dwarf::DW_LANG_C, m_debugFile, "Compiler", false, "", 0);
+    m_module->addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+    m_module->addModuleFlag(llvm::Module::Warning, "Dwarf Version", 4);
+}
+
+llvm::DIType* LlvmIRGenerator::getDebugType(Keyword type){
+    switch(type){
+        case Keyword::INT:
+            return m_debugBuilder->createBasicType("int", 32, llvm::dwarf::DW_ATE_signed);
+        case Keyword::FLOAT:
+            return m_debugBuilder->createBasicType("float", 32, llvm::dwarf::DW_ATE_float);
+        case Keyword::CHAR:
+            return m_debugBuilder->createBasicType("char", 8, llvm::dwarf::DW_ATE_signed_char);
+        case Keyword::INT4:
+        case Keyword::INT8:
+        case Keyword::FLOAT4:
+        case Keyword::FLOAT8:
+            {
+                llvm::DIType* elementType = getDebugType(getElementType(type));
+                const uint32_t laneCount = getLaneCount(type);
+                llvm::DINodeArray subscripts = m_debugBuilder->getOrCreateArray({m_debugBuilder->getOrCreateSubrange(0, laneCount)});
+                const uint32_t alignment = m_module->getDataLayout().getABITypeAlignment(getType(type)) * 8;
+                return m_debugBuilder->createVectorType(elementType->getSizeInBits() * laneCount, alignment, elementType, subscripts);
+            }
+        default:
+            return nullptr;
+    }
+}
+
+// array parameters are described as pointers to the array
+llvm::DIType* LlvmIRGenerator::getDebugType(Keyword type, uint32_t arraySize, bool isParameter){
+    llvm::DIType* elementType = getDebugType(type);
+    if(arraySize == 0){
+        return elementType;
+    }
+    const uint64_t elementSize = elementType->getSizeInBits();
+    llvm::DINodeArray subscripts = m_debugBuilder->getOrCreateArray({m_debugBuilder->getOrCreateSubrange(0, arraySize)});
+    llvm::DIType* arrayType = m_debugBuilder->createArrayType(elementSize * arraySize, elementSize, elementType, subscripts);
+    if(!isParameter){
+        return arrayType;
+    }
+    return m_debugBuilder->createPointerType(arrayType, m_module->getDataLayout().getPointerSizeInBits());
+}
+
+llvm::DISubroutineType* LlvmIRGenerator::getDebugFunctionType(ast::Function& function){
+    // first element is the return type, nullptr for void
+    std::vector<llvm::Metadata*> types = {getDebugType(function.m_returnType->m_tokenType.keywordType)};
+    for(const ast::Parameter& param: function.m_parameters){
+        types.push_back(getDebugType(param.m_dataType->m_tokenType.keywordType, param.m_arraySize, true));
+    }
+    return m_debugBuilder->createSubroutineType(m_debugBuilder->getOrCreateTypeArray(types));
+}
+
+void LlvmIRGenerator::setDebugLocation(uint32_t lineNumber){
+    if(m_debugScope == nullptr || lineNumber == 0){
+        return;
+    }
+    m_IRBuilder->SetCurrentDebugLocation(llvm::DILocation::get(*m_llvmContext, lineNumber, 0, m_debugScope));
+}
+
+// argNumber is 0 for local variables, otherwise the 1 based position of the parameter
+void LlvmIRGenerator::declareDebugVariable(llvm::AllocaInst* variable, const Token& identifier, Keyword type, uint32_t arraySize, uint32_t argNumber){
+    if(m_debugScope == nullptr){
+        return;
+    }
+    const llvm::StringRef name(identifier.m_value, identifier.m_valueSize);
+    llvm::DIType* debugType = getDebugType(type, arraySize, argNumber != 0);
+    llvm::DILocalVariable* debugVariable;
+    if(argNumber != 0){
+        debugVariable = m_debugBuilder->createParameterVariable(m_debugScope, name, argNumber, m_debugFile, identifier.m_lineNumber, debugType, true);
+    }else{
+        debugVariable = m_debugBuilder->createAutoVariable(m_debugScope, name, m_debugFile, identifier.m_lineNumber, debugType, true);
+    }
+    llvm::DILocation* location = llvm::DILocation::get(*m_llvmContext, identifier.m_lineNumber, 0, m_debugScope);
+    m_debugBuilder->insertDeclare(variable, debugVariable, m_debugBuilder->createExpression(), location, m_IRBuilder->GetInsertBlock());
+}
+
+void LlvmIRGenerator::declare(ast::Function& function){
+    const std::string identifier(function.m_identifier->m_value, function.m_identifier->m_valueSize);
+    if(m_module->getFunction(identifier) != nullptr){
+        return;
+    }
+    llvm::Function* func = llvm::Function::Create(getFunctionType(function), llvm::GlobalValue::ExternalLinkage, identifier, *m_module);
+    addParamAttributes(func, function);
+}
+
+std::unique_ptr<IRGenerator> LlvmIRGenerator::createModuleGenerator(const std::string& moduleName) const{
+    std::unique_ptr<LlvmIRGenerator> generator = std::make_unique<LlvmIRGenerator>(moduleName);
+    generator->initTargetMachine(m_targetMachine->getTargetCPU().str(), m_targetMachine->getTargetFeatureString().str());
+    return generator;
+}
+
+void LlvmIRGenerator::setTargetCpu(const std::string& cpu){
+    if(cpu != "native"){
+        if(!m_targetMachine->getMCSubtargetInfo()->isCPUStringValid(cpu)){
+            throw CompilationError("Unknown target cpu : " + cpu);
+        }
+        initTargetMachine(cpu);
+        return;
+    }
+    // host cpu name alone misses features disabled by the os or the hypervisor eg: avx512 state not saved
+    llvm::SubtargetFeatures features;
+    llvm::StringMap<bool> hostFeatures;
+    if(llvm::sys::getHostCPUFeatures(hostFeatures)){
+        for(const llvm::StringMapEntry<bool>& feature: hostFeatures){
+            features.AddFeature(feature.first(), feature.second);
+        }
+    }
+    initTargetMachine(llvm::sys::getHostCPUName().str(), features.getString());
+}
+
+void LlvmIRGenerator::enableBoundsChecks(){
+    m_boundsChecks = true;
+}
+
+void LlvmIRGenerator::setMemoCapacity(uint64_t bytes){
+    m_memoCapacity = bytes;
+}
+
+void LlvmIRGenerator::emitBitcode(std::vector<char>& buffer){
+    llvm::SmallVector<char, 0> bitcodeBuffer;
+    llvm::raw_svector_ostream output(bitcodeBuffer);
+    llvm::WriteBitcodeToFile(*m_module, output);
+    buffer.assign(bitcodeBuffer.begin(), bitcodeBuffer.end());
+}
+
+void LlvmIRGenerator::linkBitcode(const std::vector<char>& buffer, const std::string& moduleName){
+    llvm::MemoryBufferRef bitcode(llvm::StringRef(buffer.data(), buffer.size()), moduleName);
+    llvm::Expected<std::unique_ptr<llvm::Module>> module = llvm::parseBitcodeFile(bitcode, *m_llvmContext);
+    throwOnError(module.takeError());
+    if(llvm::Linker::linkModules(*m_module, std::move(*module))){
+        throw CompilationError("Could not link module : " + moduleName);
+    }
+}
+
+/*
+    All allocas are placed at the start of the entry block so that a declaration inside a loop
+    does not grow the stack on every iteration and mem2reg/sroa can promote them to registers.
+*/
+llvm::AllocaInst* LlvmIRGenerator::createEntryBlockAlloca(llvm::Type* type, std::string_view name){
+    llvm::BasicBlock& entryBlock = m_IRBuilder->GetInsertBlock()->getParent()->getEntryBlock();
+    llvm::BasicBlock::iterator insertPoint = entryBlock.begin();
+    while(insertPoint != entryBlock.end() && llvm::isa<llvm::AllocaInst>(*insertPoint)){
+        insertPoint++;
+    }
+    llvm::IRBuilder<> entryBuilder(&entryBlock, insertPoint);
+    return entryBuilder.CreateAlloca(type, nullptr, name);
 }
 
 llvm::Type* LlvmIRGenerator::getType(Token& typeToken){
@@ -86,31 +709,159 @@ llvm::Type* LlvmIRGenerator::getType(Token& typeToken){
 llvm::Type* LlvmIRGenerator::getType(Keyword type){
     switch(type){
         case Keyword::INT:
-            return intType;
+            return m_intType;
         case Keyword::FLOAT:
-            return floatType;
+            return m_floatType;
         case Keyword::CHAR:
-            return charType;
+            return m_charType;
+        case Keyword::INT4:
+        case Keyword::INT8:
+        case Keyword::FLOAT4:
+        case Keyword::FLOAT8:
+            return llvm::FixedVectorType::get(getType(getElementType(type)), getLaneCount(type));
         default:
-            return voidType;
+            return m_voidType;
+    }
+    return nullptr;
+}
+
+llvm::Type* LlvmIRGenerator::getType(const ast::Parameter& param){
+    llvm::Type* type = getType(*param.m_dataType);
+    if(param.m_arraySize == 0){
+        return type;
+    }
+    return llvm::ArrayType::get(type, param.m_arraySize)->getPointerTo();
+}
+
+// address of a local, parameter or global variable along with the type stored there
+llvm::Value* LlvmIRGenerator::getVariable(std::string_view name, llvm::Type*& type){
+    auto local = m_variables.find(name);
+    if(local != m_variables.end()){
+        type = local->second->getAllocatedType();
+        return local->second;
+    }
+    llvm::GlobalVariable* global = m_globals.at(name);
+    type = global->getValueType();
+    return global;
+}
+
+// nullptr when the variable is not an array
+llvm::ArrayType* LlvmIRGenerator::findArrayType(std::string_view name) const{
+    auto local = m_arrayTypes.find(name);
+    if(local != m_arrayTypes.end()){
+        return local->second;
+    }
+    auto global = m_globals.find(name);
+    if(global != m_globals.end()){
+        return llvm::dyn_cast<llvm::ArrayType>(global->second->getValueType());
     }
     return nullptr;
 }
 
+// address of the first element, for parameters it is the pointer passed by the caller
+llvm::Value* LlvmIRGenerator::getArray(const Token& identifier){
+    std::string_view varName(identifier.m_value, identifier.m_valueSize);
+    llvm::Type* type;
+    llvm::Value* variable = getVariable(varName, type);
+    if(type->isArrayTy()){
+        return variable;
+    }
+    return m_IRBuilder->CreateLoad(type, variable, varName);
+}
+
+llvm::Value* LlvmIRGenerator::getArrayElement(const Token& identifier, ast::Expression& index){
+    std::string_view varName(identifier.m_value, identifier.m_valueSize);
+    llvm::ArrayType* arrayType = findArrayType(varName);
+    llvm::Value* array = getArray(identifier);
+    llvm::Value* indexValue = computeExpression(index);
+    if(m_boundsChecks){
+        genBoundsCheck(indexValue, arrayType->getNumElements());
+    }
+    llvm::Value* indexes[] = {m_IRBuilder->getInt32(0), indexValue};
+    return m_IRBuilder->CreateInBoundsGEP(arrayType, array, indexes);
+}
+
+// lane index of a vector variable, the lane itself is read and written with extractelement and insertelement
+llvm::Value* LlvmIRGenerator::getLaneIndex(llvm::FixedVectorType* vectorType, ast::Expression& index){
+    llvm::Value* indexValue = computeExpression(index);
+    // out of range lanes are poison rather than out of bounds memory, they are checked all the same
+    if(m_boundsChecks){
+        genBoundsCheck(indexValue, vectorType->getNumElements());
+    }
+    return indexValue;
+}
+
+// scalars used where a vector is expected are copied to every lane
+llvm::Value* LlvmIRGenerator::broadcast(llvm::Value* value, llvm::Type* type){
+    if(!type->isVectorTy() || value->getType()->isVectorTy()){
+        return value;
+    }
+    return m_IRBuilder->CreateVectorSplat(llvm::cast<llvm::FixedVectorType>(type)->getNumElements(), value);
+}
+
+void LlvmIRGenerator::matchOperands(llvm::Value*& lhs, llvm::Value*& rhs){
+    lhs = broadcast(lhs, rhs->getType());
+    rhs = broadcast(rhs, lhs->getType());
+}
+
+/*
+    Horizontal reductions map to the llvm.vector.reduce intrinsics which lower to shuffles and vector ops.
+    Float sums and products are allowed to reassociate, otherwise lanes would be added one after another in order.
+*/
+llvm::Value* LlvmIRGenerator::genVectorReduction(std::string_view reduction, llvm::Value* vector){
+    const bool isFloat = vector->getType()->isFPOrFPVectorTy();
+    llvm::Value* value = nullptr;
+    if(reduction == "reduceAdd"){
+        value = isFloat ? m_IRBuilder->CreateFAddReduce(llvm::ConstantFP::getNegativeZero(m_floatType), vector)
+                : m_IRBuilder->CreateAddReduce(vector);
+    }else if(reduction == "reduceMul"){
+        value = isFloat ? m_IRBuilder->CreateFMulReduce(llvm::ConstantFP::get(m_floatType, 1.0), vector)
+                : m_IRBuilder->CreateMulReduce(vector);
+    }else if(reduction == "reduceMin"){
+        value = isFloat ? m_IRBuilder->CreateFPMinReduce(vector) : m_IRBuilder->CreateIntMinReduce(vector, true);
+    }else{
+        value = isFloat ? m_IRBuilder->CreateFPMaxReduce(vector) : m_IRBuilder->CreateIntMaxReduce(vector, true);
+    }
+    if(isFloat){
+        llvm::cast<llvm::Instruction>(value)->setHasAllowReassoc(true);
+    }
+    return value;
+}
+
+/*
+    A single unsigned compare covers negative indexes as well. The failing side only traps,
+    so when the index is an induction variable whose range is known from the loop condition
+    the check folds away, and a loop invariant index has its check hoisted by licm.
+*/
+void LlvmIRGenerator::genBoundsCheck(llvm::Value* index, uint64_t size){
+    llvm::Function* currentFunc = m_IRBuilder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* inBounds = llvm::BasicBlock::Create(*m_llvmContext, "inBounds", currentFunc);
+    llvm::BasicBlock* outOfBounds = llvm::BasicBlock::Create(*m_llvmContext, "outOfBounds", currentFunc);
+    llvm::Value* isInBounds = m_IRBuilder->CreateICmpULT(index, llvm::ConstantInt::get(index->getType(), size));
+    // same weights as __builtin_expect, keeps the trap out of the hot path
+    llvm::MDBuilder mdBuilder(*m_llvmContext);
+    m_IRBuilder->CreateCondBr(isInBounds, inBounds, outOfBounds, mdBuilder.createBranchWeights(2000, 1));
+
+    m_IRBuilder->SetInsertPoint(outOfBounds);
+    m_IRBuilder->CreateCall(llvm::Intrinsic::getDeclaration(m_module.get(), llvm::Intrinsic::trap));
+    m_IRBuilder->CreateUnreachable();
+    m_IRBuilder->SetInsertPoint(inBounds);
+}
+
 llvm::Value* LlvmIRGenerator::getFactor(ast::Factor& factor){
     
     auto fetchLiteralValue= [&](Token& token)->llvm::Value*{
         llvm::Type* type = getType(token);  
         if(token.m_tokenType == Type::STRING_LITERAL){
-            return llvm::ConstantInt::get(charType, token.m_value[0]);
+            return llvm::ConstantInt::get(m_charType, token.m_value[0]);
         }else if(token.m_tokenType == Type::NUMERIC_LITERAL){
             std::string value(token.m_value, token.m_valueSize);
             if(token.m_tokenType.isFloatingPointValue){
                 float convertedValue = std::stof(value);
-                return llvm::ConstantFP::get(floatType, convertedValue);
+                return llvm::ConstantFP::get(m_floatType, convertedValue);
             }
             int convertedValue = std::stoi(value);
-            return llvm::ConstantInt::get(intType, convertedValue);
+            return llvm::ConstantInt::get(m_intType, convertedValue);
         }
         return nullptr;
     };
@@ -122,9 +873,13 @@ llvm::Value* LlvmIRGenerator::getFactor(ast::Factor& factor){
                 Token& valueToken = *factor.operand.value;
                 if(valueToken.m_tokenType == Type::IDENTIFIER){
                     std::string_view varName(valueToken.m_value, valueToken.m_valueSize);
-                    auto it = m_variables.find(varName);
-                    llvm::Type* type = it->second->getAllocatedType();
-                    llvm::LoadInst* loadValue = m_IRBuilder->CreateLoad(type, it->second, "loadValue");
+                    // arrays are only used as values when passed to a function
+                    if(findArrayType(varName) != nullptr){
+                        return getArray(valueToken);
+                    }
+                    llvm::Type* type;
+                    llvm::Value* variable = getVariable(varName, type);
+                    llvm::LoadInst* loadValue = m_IRBuilder->CreateLoad(type, variable, "loadValue");
                     return loadValue;
                 }
                 return fetchLiteralValue(valueToken);
@@ -133,6 +888,21 @@ llvm::Value* LlvmIRGenerator::getFactor(ast::Factor& factor){
             return computeExpression(*factor.operand.expression);
         case ast::Factor::OperandType::FUNCTION_CALL:
             return genInstruction(*factor.operand.functionCall);
+        case ast::Factor::OperandType::ARRAY_ACCESS:
+            {
+                ast::ArrayAccess& arrayAccess = *factor.operand.arrayAccess;
+                std::string_view varName(arrayAccess.m_identifier->m_value, arrayAccess.m_identifier->m_valueSize);
+                llvm::ArrayType* arrayType = findArrayType(varName);
+                if(arrayType == nullptr){
+                    llvm::Type* type;
+                    llvm::Value* variable = getVariable(varName, type);
+                    llvm::FixedVectorType* vectorType = llvm::cast<llvm::FixedVectorType>(type);
+                    llvm::Value* lane = getLaneIndex(vectorType, *arrayAccess.m_index);
+                    return m_IRBuilder->CreateExtractElement(m_IRBuilder->CreateLoad(vectorType, variable), lane);
+                }
+                llvm::Type* elementType = arrayType->getElementType();
+                return m_IRBuilder->CreateLoad(elementType, getArrayElement(*arrayAccess.m_identifier, *arrayAccess.m_index));
+            }
     }
     return nullptr;
 }
@@ -141,17 +911,18 @@ llvm::Value* LlvmIRGenerator::computeTerm(ast::Term& term){
     llvm::Value* lhs = getFactor(*term.m_factor);
     ast::TermTail* termTail = term.m_termTail;
     bool isFloat = false;
-    if(lhs->getType()->isFloatingPointTy()){
+    if(lhs->getType()->isFPOrFPVectorTy()){
         isFloat = true;
     }
     while(termTail != nullptr){
         llvm::Value* rhs = getFactor(*termTail->m_factor);
+        matchOperands(lhs, rhs);
         ast::Opcode opcode = termTail->m_opcode;
         if(opcode == ast::Opcode::MULTIPLICATION){
             if(isFloat)
                 lhs = m_IRBuilder->CreateFMul(lhs, rhs);
             else
-                lhs = m_IRBuilder->CreateSub(lhs, rhs);
+                lhs = m_IRBuilder->CreateMul(lhs, rhs);
         }else if(opcode == ast::Opcode::DIVISION){
             if(isFloat)
                 lhs = m_IRBuilder->CreateFDiv(lhs, rhs);
@@ -167,11 +938,12 @@ llvm::Value* LlvmIRGenerator::computeAdditive(ast::Additive& additive){
     llvm::Value* lhs = computeTerm(*additive.m_term);
     ast::AdditiveTail* additiveTail = additive.m_additiveTail;
     bool isFloat = false;
-    if(lhs->getType()->isFloatingPointTy()){
+    if(lhs->getType()->isFPOrFPVectorTy()){
         isFloat = true;
     }
     while(additiveTail != nullptr){
         llvm::Value* rhs = computeTerm(*additiveTail->m_term);
+        matchOperands(lhs, rhs);
         ast::Opcode opcode = additiveTail->m_opcode;
         if(opcode == ast::Opcode::ADDITION){
             if(isFloat)
@@ -221,39 +993,200 @@ llvm::Value* LlvmIRGenerator::computeRelational(ast::Relational& relational){
     return lhs;
 }
 
+llvm::Value* LlvmIRGenerator::toCondition(llvm::Value* value){
+    if(value->getType()->isIntegerTy(1)){
+        return value;
+    }
+    if(value->getType()->isFloatingPointTy()){
+        return m_IRBuilder->CreateFCmpUNE(value, llvm::ConstantFP::get(value->getType(), 0.0));
+    }
+    return m_IRBuilder->CreateICmpNE(value, llvm::ConstantInt::get(value->getType(), 0));
+}
+
+/*
+    Logical operators are short circuited, right hand side is only evaluated
+    when left hand side does not already decide the result.
+*/
 llvm::Value* LlvmIRGenerator::computeExpression(ast::Expression& expression){
     llvm::Value* lhs = computeRelational(*expression.m_relational);
     ast::ExpressionTail* exprTail = expression.m_expressionTail;
     while(exprTail != nullptr){
-        llvm::Value* rhs = computeRelational(*exprTail->m_relational);
-        ast::Opcode opcode = exprTail->m_opcode;
-        if(opcode == ast::Opcode::LOGICAL_AND){
-            lhs = m_IRBuilder->CreateAnd(lhs, rhs);
-        }else if(opcode == ast::Opcode::LOGICAL_OR){
-            lhs = m_IRBuilder->CreateOr(lhs, rhs);
+        lhs = toCondition(lhs);
+        llvm::BasicBlock* lhsBlock = m_IRBuilder->GetInsertBlock();
+        llvm::Function* currentFunc = lhsBlock->getParent();
+        llvm::BasicBlock* rhsBlock = llvm::BasicBlock::Create(*m_llvmContext, "logicalRhs", currentFunc);
+        llvm::BasicBlock* mergeBlock = llvm::BasicBlock::Create(*m_llvmContext, "logicalEnd", currentFunc);
+        bool isAnd = (exprTail->m_opcode == ast::Opcode::LOGICAL_AND);
+        if(isAnd){
+            m_IRBuilder->CreateCondBr(lhs, rhsBlock, mergeBlock);
+        }else{
+            m_IRBuilder->CreateCondBr(lhs, mergeBlock, rhsBlock);
         }
+
+        m_IRBuilder->SetInsertPoint(rhsBlock);
+        llvm::Value* rhs = toCondition(computeRelational(*exprTail->m_relational));
+        llvm::BasicBlock* rhsEndBlock = m_IRBuilder->GetInsertBlock();
+        m_IRBuilder->CreateBr(mergeBlock);
+
+        m_IRBuilder->SetInsertPoint(mergeBlock);
+        llvm::PHINode* result = m_IRBuilder->CreatePHI(m_IRBuilder->getInt1Ty(), 2);
+        result->addIncoming(m_IRBuilder->getInt1(!isAnd), lhsBlock);
+        result->addIncoming(rhs, rhsEndBlock);
+        lhs = result;
         exprTail = exprTail->m_expressionTail;
     }
     return lhs;
 }
 
+/*
+    Lowers condition of if / while directly into branches. Logical operators are left associative
+    so the last operator decides where the prefix before it jumps eg: for (a && b) || c
+    prefix (a && b) jumps to onTrue or to the block evaluating c.
+*/
+void LlvmIRGenerator::genCondition(ast::Expression& expression, llvm::BasicBlock* onTrue, llvm::BasicBlock* onFalse){
+    std::vector<ast::ExpressionTail*> exprTails;
+    for(ast::ExpressionTail* exprTail = expression.m_expressionTail; exprTail != nullptr; exprTail = exprTail->m_expressionTail){
+        exprTails.push_back(exprTail);
+    }
+    genCondition(expression, exprTails, exprTails.size(), onTrue, onFalse);
+}
+
+void LlvmIRGenerator::genCondition(ast::Expression& expression, std::vector<ast::ExpressionTail*>& exprTails, size_t size,
+        llvm::BasicBlock* onTrue, llvm::BasicBlock* onFalse){
+    if(size == 0){
+        llvm::Value* condition = toCondition(computeRelational(*expression.m_relational));
+        m_IRBuilder->CreateCondBr(condition, onTrue, onFalse);
+        return;
+    }
+    ast::ExpressionTail* exprTail = exprTails[size-1];
+    llvm::Function* currentFunc = m_IRBuilder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* rhsBlock = llvm::BasicBlock::Create(*m_llvmContext, "logicalRhs", currentFunc);
+    if(exprTail->m_opcode == ast::Opcode::LOGICAL_AND){
+        genCondition(expression, exprTails, size-1, rhsBlock, onFalse);
+    }else{
+        genCondition(expression, exprTails, size-1, onTrue, rhsBlock);
+    }
+    m_IRBuilder->SetInsertPoint(rhsBlock);
+    llvm::Value* condition = toCondition(computeRelational(*exprTail->m_relational));
+    m_IRBuilder->CreateCondBr(condition, onTrue, onFalse);
+}
+
 
 void LlvmIRGenerator::genInstruction(ast::DeclarativeStatement& declarativeStatement){
+    // every use of a folded const has already been replaced by its literal
+    if(declarativeStatement.m_isCompileTimeConstant){
+        return;
+    }
     llvm::Type* dataType = getType(*declarativeStatement.m_dataType);
     std::string_view varIdentifier(declarativeStatement.m_identifier->m_value, declarativeStatement.m_identifier->m_valueSize);
-    llvm::AllocaInst* variable = m_IRBuilder->CreateAlloca(dataType, nullptr, varIdentifier);
-    if(declarativeStatement.m_isInitialized){
-        llvm::Value* value = computeExpression(*declarativeStatement.m_expression);
+    if(declarativeStatement.m_arraySize != 0){
+        llvm::ArrayType* arrayType = llvm::ArrayType::get(dataType, declarativeStatement.m_arraySize);
+        m_arrayTypes.insert({varIdentifier, arrayType});
+        dataType = arrayType;
+    }
+    llvm::AllocaInst* variable = createEntryBlockAlloca(dataType, varIdentifier);
+    declareDebugVariable(variable, *declarativeStatement.m_identifier, declarativeStatement.m_dataType->m_tokenType.keywordType,
+            declarativeStatement.m_arraySize, 0);
+    if(declarativeStatement.m_arraySize != 0 && declarativeStatement.m_isInitialized){
+        genArrayInitializer(declarativeStatement, variable);
+    }else if(declarativeStatement.m_isInitialized){
+        llvm::Value* value = broadcast(computeExpression(*declarativeStatement.m_expression), dataType);
         m_IRBuilder->CreateStore(value, variable);
     }
     m_variables.insert({varIdentifier, variable});
 }
 
+// constant elements are copied from read only data, otherwise they are stored one by one over zeroes
+void LlvmIRGenerator::genArrayInitializer(ast::DeclarativeStatement& declarativeStatement, llvm::AllocaInst* variable){
+    llvm::ArrayType* arrayType = llvm::cast<llvm::ArrayType>(variable->getAllocatedType());
+    llvm::Type* elementType = arrayType->getElementType();
+    std::vector<llvm::Value*> elements;
+    bool isConstant = true;
+    for(ast::Expression* element: declarativeStatement.m_elements){
+        elements.push_back(broadcast(computeExpression(*element), elementType));
+        isConstant = isConstant && llvm::isa<llvm::Constant>(elements.back());
+    }
+    const uint64_t size = m_module->getDataLayout().getTypeAllocSize(arrayType);
+    if(isConstant){
+        std::vector<llvm::Constant*> constants;
+        for(llvm::Value* element: elements){
+            constants.push_back(llvm::cast<llvm::Constant>(element));
+        }
+        constants.resize(arrayType->getNumElements(), llvm::Constant::getNullValue(elementType));
+        llvm::GlobalVariable* initializer = new llvm::GlobalVariable(*m_module, arrayType, true, llvm::GlobalValue::PrivateLinkage,
+                llvm::ConstantArray::get(arrayType, constants), variable->getName() + ".init");
+        initializer->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+        initializer->setAlignment(variable->getAlign());
+        m_IRBuilder->CreateMemCpy(variable, variable->getAlign(), initializer, variable->getAlign(), size);
+        return;
+    }
+    m_IRBuilder->CreateMemSet(variable, m_IRBuilder->getInt8(0), size, variable->getAlign());
+    for(size_t i=0;i<elements.size();i++){
+        llvm::Value* indexes[] = {m_IRBuilder->getInt32(0), m_IRBuilder->getInt32(i)};
+        m_IRBuilder->CreateStore(elements[i], m_IRBuilder->CreateInBoundsGEP(arrayType, variable, indexes));
+    }
+}
+
+/*
+    Globals are private to their file. Constants are emitted as constant unnamed_addr data, so they are placed in
+    .rodata and the optimizer can read their elements at compile time, other globals start out in .data or .bss.
+*/
+void LlvmIRGenerator::genGlobal(ast::DeclarativeStatement& declarativeStatement){
+    // every use of a folded const has already been replaced by its literal
+    if(declarativeStatement.m_isCompileTimeConstant){
+        return;
+    }
+    const Token& identifier = *declarativeStatement.m_identifier;
+    const std::string_view varIdentifier(identifier.m_value, identifier.m_valueSize);
+    llvm::Type* dataType = getType(*declarativeStatement.m_dataType);
+    llvm::Constant* initializer;
+    if(declarativeStatement.m_arraySize != 0){
+        std::vector<llvm::Constant*> elements;
+        for(ast::Expression* element: declarativeStatement.m_elements){
+            elements.push_back(llvm::cast<llvm::Constant>(broadcast(computeExpression(*element), dataType)));
+        }
+        elements.resize(declarativeStatement.m_arraySize, llvm::Constant::getNullValue(dataType));
+        llvm::ArrayType* arrayType = llvm::ArrayType::get(dataType, declarativeStatement.m_arraySize);
+        initializer = llvm::ConstantArray::get(arrayType, elements);
+        dataType = arrayType;
+    }else if(declarativeStatement.m_expression != nullptr){
+        initializer = llvm::cast<llvm::Constant>(broadcast(computeExpression(*declarativeStatement.m_expression), dataType));
+    }else{
+        initializer = llvm::Constant::getNullValue(dataType);
+    }
+    llvm::GlobalVariable* global = new llvm::GlobalVariable(*m_module, dataType, declarativeStatement.m_isConst, llvm::GlobalValue::InternalLinkage,
+            initializer, llvm::StringRef(varIdentifier.data(), varIdentifier.size()));
+    if(declarativeStatement.m_isConst){
+        global->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    }
+    if(m_debugBuilder != nullptr){
+        const llvm::StringRef name(varIdentifier.data(), varIdentifier.size());
+        llvm::DIType* debugType = getDebugType(declarativeStatement.m_dataType->m_tokenType.keywordType, declarativeStatement.m_arraySize, false);
+        global->addDebugInfo(m_debugBuilder->createGlobalVariableExpression(m_debugFile, name, name, m_debugFile, identifier.m_lineNumber, debugType, true));
+    }
+    m_globals.insert({varIdentifier, global});
+}
+
 void LlvmIRGenerator::genInstruction(ast::AssignmentStatement& assignmentStatement){
     std::string_view varIdentifier(assignmentStatement.m_identifier->m_value, assignmentStatement.m_identifier->m_valueSize);
-    auto var = m_variables.find(varIdentifier);
-    llvm::Value* value = computeExpression(*assignmentStatement.m_expression);
-    m_IRBuilder->CreateStore(value, var->second);
+    llvm::Type* type;
+    llvm::Value* variable = getVariable(varIdentifier, type);
+    llvm::ArrayType* arrayType = findArrayType(varIdentifier);
+    if(assignmentStatement.m_index != nullptr && arrayType == nullptr){
+        llvm::FixedVectorType* vectorType = llvm::cast<llvm::FixedVectorType>(type);
+        llvm::Value* lane = getLaneIndex(vectorType, *assignmentStatement.m_index);
+        llvm::Value* value = computeExpression(*assignmentStatement.m_expression);
+        llvm::Value* vector = m_IRBuilder->CreateLoad(vectorType, variable);
+        m_IRBuilder->CreateStore(m_IRBuilder->CreateInsertElement(vector, value, lane), variable);
+        return;
+    }
+    llvm::Value* address = variable;
+    if(assignmentStatement.m_index != nullptr){
+        address = getArrayElement(*assignmentStatement.m_identifier, *assignmentStatement.m_index);
+        type = arrayType->getElementType();
+    }
+    llvm::Value* value = broadcast(computeExpression(*assignmentStatement.m_expression), type);
+    m_IRBuilder->CreateStore(value, address);
 }
 
 void LlvmIRGenerator::genInstruction(ast::ReturnStatement& returnStatment){
@@ -261,19 +1194,65 @@ void LlvmIRGenerator::genInstruction(ast::ReturnStatement& returnStatment){
         m_IRBuilder->CreateRetVoid();
         return;
     }
+    ast::FunctionCallStatement* tailCall = findTailCall(*returnStatment.m_expr);
+    if(tailCall != nullptr && !passesLocalArray(*tailCall)){
+        llvm::StringRef functionName(tailCall->m_identifier->m_value, tailCall->m_identifier->m_valueSize);
+        if(functionName == m_functionBody->getParent()->getName()){
+            genSelfTailCall(*tailCall);
+            return;
+        }
+        llvm::CallInst* call = llvm::cast<llvm::CallInst>(genInstruction(*tailCall));
+        call->setTailCall();
+        m_IRBuilder->CreateRet(broadcast(call, m_functionBody->getParent()->getReturnType()));
+        return;
+    }
     llvm::Value* value = computeExpression(*returnStatment.m_expr);
-    m_IRBuilder->CreateRet(value);
+    m_IRBuilder->CreateRet(broadcast(value, m_functionBody->getParent()->getReturnType()));
+}
+
+// a callee given an array of this frame cannot run in place of it
+bool LlvmIRGenerator::passesLocalArray(const ast::FunctionCallStatement& functionCallStatement){
+    for(const ast::Expression* arg: functionCallStatement.m_args){
+        const ast::Factor& factor = *arg->m_relational->m_additive->m_term->m_factor;
+        if(factor.operandType != ast::Factor::OperandType::VALUE || factor.operand.value->m_tokenType.type != Type::IDENTIFIER){
+            continue;
+        }
+        auto variable = m_variables.find(std::string_view(factor.operand.value->m_value, factor.operand.value->m_valueSize));
+        if(variable != m_variables.end() && variable->second->getAllocatedType()->isArrayTy()){
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+    return f(...) inside f is turned into a jump back to the start of f with the new arguments,
+    so the recursion runs in constant stack space at every optimization level.
+*/
+void LlvmIRGenerator::genSelfTailCall(ast::FunctionCallStatement& functionCallStatement){
+    // every argument is computed before any parameter is overwritten, they may read each other
+    std::vector<llvm::Value*> args;
+    for(ast::Expression* arg: functionCallStatement.m_args){
+        args.push_back(computeExpression(*arg));
+    }
+    for(size_t i=0;i<args.size();i++){
+        m_IRBuilder->CreateStore(broadcast(args[i], m_parameters[i]->getAllocatedType()), m_parameters[i]);
+    }
+    m_IRBuilder->CreateBr(m_functionBody);
 }
 
  llvm::Value* LlvmIRGenerator::genInstruction(ast::FunctionCallStatement& functionCallStatement){
     std::string_view functionName(functionCallStatement.m_identifier->m_value, functionCallStatement.m_identifier->m_valueSize);
+    if(SymbolTableHandler::isVectorReduction(functionName)){
+        return genVectorReduction(functionName, computeExpression(*functionCallStatement.m_args.front()));
+    }
     llvm::Function* function = m_module->getFunction(functionName);
     if(functionCallStatement.m_args.empty()){
         return m_IRBuilder->CreateCall(function);
     }
     std::vector<llvm::Value*> params;
     for(ast::Expression* arg: functionCallStatement.m_args){
-        llvm::Value* argValue = computeExpression(*arg);
+        llvm::Value* argValue = broadcast(computeExpression(*arg), function->getArg(params.size())->getType());
         params.push_back(argValue);
     }
     llvm::Value* value = m_IRBuilder->CreateCall(function, params);
@@ -281,57 +1260,134 @@ void LlvmIRGenerator::genInstruction(ast::ReturnStatement& returnStatment){
  }
 
  void LlvmIRGenerator::genInstruction(ast::ConditionalStatement& conditionalStatement, llvm::BasicBlock* finalBlock){
-    llvm::Value* conditionExpr = computeExpression(*conditionalStatement.m_expr);
+    if(finalBlock == nullptr && genSwitch(conditionalStatement)){
+        return;
+    }
     llvm::BasicBlock* initialBlock = m_IRBuilder->GetInsertBlock();
     llvm::Function* currentFunc = initialBlock->getParent();
-    llvm::BasicBlock* onTrue = llvm::BasicBlock::Create(*llvmContext, "onTrue", currentFunc);
+    llvm::BasicBlock* onTrue = llvm::BasicBlock::Create(*m_llvmContext, "onTrue", currentFunc);
     if(finalBlock== nullptr)
-        finalBlock = llvm::BasicBlock::Create(*llvmContext, "finalBlock", currentFunc);
-
-    auto fillInstructions = [&](std::list<ast::Statement*>& stmnts){
-        bool hasReturnStatement = false;
-        for(ast::Statement* stmnt: stmnts){
-            genInstruction(*stmnt);
-            if(stmnt->m_type == ast::Statement::Type::RETURN){
-                hasReturnStatement = true;
-                break;
-            };
-        }
-        if(!hasReturnStatement){
-            m_IRBuilder->CreateBr(finalBlock);
-        }
-    };
+        finalBlock = llvm::BasicBlock::Create(*m_llvmContext, "finalBlock", currentFunc);
+    llvm::BasicBlock* onFalse = finalBlock;
+    if(conditionalStatement.m_else != nullptr){
+        onFalse = llvm::BasicBlock::Create(*m_llvmContext, "onFalse", currentFunc);
+    }
+    // else if conditions are not statements of their own
+    setDebugLocation(findLineNumber(*conditionalStatement.m_expr));
+    genCondition(*conditionalStatement.m_expr, onTrue, onFalse);
+
     m_IRBuilder->SetInsertPoint(onTrue);
-    fillInstructions(conditionalStatement.m_stmnts);
+    genBranchBody(conditionalStatement.m_stmnts, finalBlock);
 
-    m_IRBuilder->SetInsertPoint(initialBlock);
     if(conditionalStatement.m_else != nullptr){
-        llvm::BasicBlock* onFalse = llvm::BasicBlock::Create(*llvmContext, "onFalse", currentFunc);
-        m_IRBuilder->CreateCondBr(conditionExpr, onTrue, onFalse);
         m_IRBuilder->SetInsertPoint(onFalse);
         if(conditionalStatement.m_else->m_expr != nullptr){
             genInstruction(*conditionalStatement.m_else, finalBlock);
         }else{
-            fillInstructions(conditionalStatement.m_else->m_stmnts);
+            genBranchBody(conditionalStatement.m_else->m_stmnts, finalBlock);
         }
-        m_IRBuilder->SetInsertPoint(finalBlock);
-        return;
+    }
+    m_IRBuilder->SetInsertPoint(finalBlock);
+}
 
+/*
+    Leading arms of an if else if chain that compare the same int or char variable with distinct literals
+    become the cases of a switch, so the backend can dispatch through a jump table or a binary search.
+    The remaining arms (if any) are generated as usual in the default block.
+    Returns false if the chain does not start with at least two such arms.
+*/
+bool LlvmIRGenerator::genSwitch(ast::ConditionalStatement& conditionalStatement){
+    llvm::AllocaInst* variable = nullptr;
+    std::vector<std::pair<llvm::ConstantInt*, ast::ConditionalStatement*>> cases;
+    std::unordered_set<int32_t> caseValues;
+    ast::ConditionalStatement* defaultArm = &conditionalStatement;
+    for(; defaultArm != nullptr && defaultArm->m_expr != nullptr; defaultArm = defaultArm->m_else){
+        const Token* identifier;
+        ConstantValue value;
+        if(!findEqualityTest(*defaultArm->m_expr, identifier, value)){
+            break;
+        }
+        auto it = m_variables.find(std::string_view(identifier->m_value, identifier->m_valueSize));
+        if(it == m_variables.end() || (variable != nullptr && it->second != variable)){
+            break;
+        }
+        llvm::Type* type = it->second->getAllocatedType();
+        int32_t caseValue;
+        if(type == m_intType && value.dataType == Keyword::INT){
+            caseValue = value.intValue;
+        }else if(type == m_charType && value.dataType == Keyword::CHAR){
+            caseValue = static_cast<int8_t>(value.charValue);
+        }else{
+            break;
+        }
+        // a repeated value can never be taken, it is left to the default block along with the rest
+        if(!caseValues.insert(caseValue).second){
+            break;
+        }
+        variable = it->second;
+        cases.push_back({llvm::ConstantInt::getSigned(llvm::cast<llvm::IntegerType>(type), caseValue), defaultArm});
+    }
+    if(cases.size() < 2){
+        return false;
+    }
+
+    llvm::Function* currentFunc = m_IRBuilder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* finalBlock = llvm::BasicBlock::Create(*m_llvmContext, "finalBlock", currentFunc);
+    llvm::BasicBlock* defaultBlock = finalBlock;
+    if(defaultArm != nullptr){
+        defaultBlock = llvm::BasicBlock::Create(*m_llvmContext, "switchDefault", currentFunc);
+    }
+    setDebugLocation(findLineNumber(*conditionalStatement.m_expr));
+    llvm::Value* switchValue = m_IRBuilder->CreateLoad(variable->getAllocatedType(), variable, "switchValue");
+    llvm::SwitchInst* switchInst = m_IRBuilder->CreateSwitch(switchValue, defaultBlock, cases.size());
+    for(const auto& switchCase: cases){
+        llvm::BasicBlock* caseBlock = llvm::BasicBlock::Create(*m_llvmContext, "switchCase", currentFunc);
+        switchInst->addCase(switchCase.first, caseBlock);
+        m_IRBuilder->SetInsertPoint(caseBlock);
+        genBranchBody(switchCase.second->m_stmnts, finalBlock);
+    }
+    if(defaultArm != nullptr){
+        m_IRBuilder->SetInsertPoint(defaultBlock);
+        if(defaultArm->m_expr != nullptr){
+            genInstruction(*defaultArm, finalBlock);
+        }else{
+            genBranchBody(defaultArm->m_stmnts, finalBlock);
+        }
     }
-    m_IRBuilder->CreateCondBr(conditionExpr, onTrue, finalBlock);
     m_IRBuilder->SetInsertPoint(finalBlock);
+    return true;
 }
 
+void LlvmIRGenerator::genBranchBody(std::list<ast::Statement*>& stmnts, llvm::BasicBlock* finalBlock){
+    for(ast::Statement* stmnt: stmnts){
+        genInstruction(*stmnt);
+        if(stmnt->m_type == ast::Statement::Type::RETURN){
+            return;
+        }
+    }
+    m_IRBuilder->CreateBr(finalBlock);
+}
+
+/*
+    While loop is lowered into the canonical shape recognized by loop passes:
+    header evaluates the condition, body jumps to a single latch, latch jumps back to header.
+*/
 void LlvmIRGenerator::genInstruction(ast::WhileLoop& whileLoop){
-    llvm::Value* conditionalExpr = computeExpression(*whileLoop.m_expr);
-    llvm::BasicBlock* currentBlock = m_IRBuilder->GetInsertBlock();
-    llvm::Function* currentFunc = currentBlock->getParent();
-    llvm::BasicBlock* loopBlock = llvm::BasicBlock::Create(*llvmContext, "loop", currentFunc);
-    llvm::BasicBlock* finalBlock = llvm::BasicBlock::Create(*llvmContext, "final", currentFunc);
+    if(whileLoop.m_hints.m_parallel){
+        genParallelLoop(whileLoop);
+        return;
+    }
+    llvm::Function* currentFunc = m_IRBuilder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* headerBlock = llvm::BasicBlock::Create(*m_llvmContext, "loopHeader", currentFunc);
+    llvm::BasicBlock* bodyBlock = llvm::BasicBlock::Create(*m_llvmContext, "loopBody", currentFunc);
+    llvm::BasicBlock* latchBlock = llvm::BasicBlock::Create(*m_llvmContext, "loopLatch", currentFunc);
+    llvm::BasicBlock* finalBlock = llvm::BasicBlock::Create(*m_llvmContext, "loopExit", currentFunc);
 
-    m_IRBuilder->CreateCondBr(conditionalExpr, loopBlock, finalBlock);
+    m_IRBuilder->CreateBr(headerBlock);
+    m_IRBuilder->SetInsertPoint(headerBlock);
+    genCondition(*whileLoop.m_expr, bodyBlock, finalBlock);
 
-    m_IRBuilder->SetInsertPoint(loopBlock);
+    m_IRBuilder->SetInsertPoint(bodyBlock);
     bool hasReturnStatement = false;
     for(ast::Statement* stmnt: whileLoop.m_stmnts){
         genInstruction(*stmnt);
@@ -341,13 +1397,161 @@ void LlvmIRGenerator::genInstruction(ast::WhileLoop& whileLoop){
         }
     }
     if(!hasReturnStatement){
-        conditionalExpr = computeExpression(*whileLoop.m_expr);
-        m_IRBuilder->CreateCondBr(conditionalExpr, loopBlock, finalBlock);
+        m_IRBuilder->CreateBr(latchBlock);
     }
+    m_IRBuilder->SetInsertPoint(latchBlock);
+    setDebugLocation(findLineNumber(*whileLoop.m_expr));
+    llvm::BranchInst* backEdge = m_IRBuilder->CreateBr(headerBlock);
+    backEdge->setMetadata(llvm::LLVMContext::MD_loop, createLoopMetadata(whileLoop.m_hints));
+
     m_IRBuilder->SetInsertPoint(finalBlock); 
 }
 
+/*
+    The body of a parallel loop is outlined into a function running a block of iterations, which the
+    runtime calls from every thread. Variables of the enclosing function are copied into a context
+    struct, arrays by address, the body only writes to array elements and its own variables.
+*/
+void LlvmIRGenerator::genParallelLoop(ast::WhileLoop& whileLoop){
+    ast::Relational& condition = *whileLoop.m_expr->m_relational;
+    const Token& counter = *condition.m_additive->m_term->m_factor->operand.value;
+    llvm::AllocaInst* counterVariable = m_variables.at(std::string_view(counter.m_value, counter.m_valueSize));
+    llvm::Value* begin = m_IRBuilder->CreateLoad(m_intType, counterVariable);
+    llvm::Value* end = computeAdditive(*condition.m_relationalTail->m_additive);
+
+    std::vector<std::pair<std::string_view, llvm::Type*>> captures;
+    std::vector<llvm::Type*> fieldTypes;
+    for(const auto& variable: m_variables){
+        llvm::Type* type = variable.second->getAllocatedType();
+        if(type->isArrayTy()){
+            type = type->getPointerTo();
+        }
+        captures.push_back({variable.first, type});
+        fieldTypes.push_back(type);
+    }
+    llvm::StructType* contextType = llvm::StructType::get(*m_llvmContext, fieldTypes);
+    llvm::AllocaInst* context = createEntryBlockAlloca(contextType, "parallelContext");
+    for(size_t i=0;i<captures.size();i++){
+        llvm::AllocaInst* variable = m_variables.at(captures[i].first);
+        llvm::Value* value = variable;
+        if(!variable->getAllocatedType()->isArrayTy()){
+            value = m_IRBuilder->CreateLoad(variable->getAllocatedType(), variable);
+        }
+        m_IRBuilder->CreateStore(value, m_IRBuilder->CreateStructGEP(contextType, context, i));
+    }
+    llvm::Function* body = genParallelBody(whileLoop, captures, contextType);
+
+    llvm::Type* bytePointer = m_charType->getPointerTo();
+    llvm::FunctionType* runtimeType = llvm::FunctionType::get(m_voidType,
+            {body->getType(), bytePointer, m_intType, m_intType, m_intType}, false);
+    llvm::FunctionCallee runtime = m_module->getOrInsertFunction("parallelFor", runtimeType);
+    m_IRBuilder->CreateCall(runtime, {body, m_IRBuilder->CreateBitCast(context, bytePointer), begin, end,
+            m_IRBuilder->getInt32(whileLoop.m_hints.m_parallelGrain)});
+    // counter is left where the sequential loop would leave it
+    llvm::Value* hasIterations = m_IRBuilder->CreateICmpSLT(begin, end);
+    m_IRBuilder->CreateStore(m_IRBuilder->CreateSelect(hasIterations, end, begin), counterVariable);
+}
+
+llvm::Function* LlvmIRGenerator::genParallelBody(ast::WhileLoop& whileLoop, const std::vector<std::pair<std::string_view, llvm::Type*>>& captures,
+        llvm::StructType* contextType){
+    llvm::Function* parent = m_IRBuilder->GetInsertBlock()->getParent();
+    llvm::FunctionType* funcType = llvm::FunctionType::get(m_voidType, {m_charType->getPointerTo(), m_intType, m_intType}, false);
+    llvm::Function* func = llvm::Function::Create(funcType, llvm::GlobalValue::InternalLinkage, parent->getName() + ".parallel", *m_module);
+    setTargetAttributes(func);
+
+    // generator state of the enclosing function is restored once the body is generated
+    llvm::IRBuilderBase::InsertPointGuard insertPointGuard(*m_IRBuilder);
+    std::unordered_map<std::string_view, llvm::AllocaInst*> variables = std::move(m_variables);
+    std::vector<llvm::AllocaInst*> parameters = std::move(m_parameters);
+    llvm::BasicBlock* functionBody = m_functionBody;
+    llvm::DISubprogram* debugScope = m_debugScope;
+    m_variables.clear();
+    m_parameters.clear();
+    m_functionBody = nullptr;
+
+    llvm::BasicBlock* entryBlock = llvm::BasicBlock::Create(*m_llvmContext, "entry", func);
+    m_IRBuilder->SetInsertPoint(entryBlock);
+    if(m_debugBuilder != nullptr){
+        const uint32_t lineNumber = findLineNumber(*whileLoop.m_expr);
+        m_debugScope = m_debugBuilder->createFunction(m_debugFile, func->getName(), llvm::StringRef(), m_debugFile, lineNumber,
+                m_debugBuilder->createSubroutineType(m_debugBuilder->getOrCreateTypeArray({nullptr})), lineNumber, llvm::DINode::FlagPrototyped,
+                llvm::DISubprogram::SPFlagDefinition | llvm::DISubprogram::SPFlagLocalToUnit);
+        func->setSubprogram(m_debugScope);
+        func->addFnAttr("frame-pointer", "all");
+        setDebugLocation(lineNumber);
+    }
+    llvm::Value* context = m_IRBuilder->CreateBitCast(func->getArg(0), contextType->getPointerTo());
+    for(size_t i=0;i<captures.size();i++){
+        llvm::AllocaInst* variable = m_IRBuilder->CreateAlloca(captures[i].second, nullptr, captures[i].first);
+        llvm::Value* field = m_IRBuilder->CreateStructGEP(contextType, context, i);
+        m_IRBuilder->CreateStore(m_IRBuilder->CreateLoad(captures[i].second, field), variable);
+        m_variables.insert({captures[i].first, variable});
+    }
+    ast::Relational& condition = *whileLoop.m_expr->m_relational;
+    const Token& counter = *condition.m_additive->m_term->m_factor->operand.value;
+    llvm::AllocaInst* counterVariable = m_variables.at(std::string_view(counter.m_value, counter.m_valueSize));
+    m_IRBuilder->CreateStore(func->getArg(1), counterVariable);
+
+    llvm::BasicBlock* headerBlock = llvm::BasicBlock::Create(*m_llvmContext, "loopHeader", func);
+    llvm::BasicBlock* bodyBlock = llvm::BasicBlock::Create(*m_llvmContext, "loopBody", func);
+    llvm::BasicBlock* latchBlock = llvm::BasicBlock::Create(*m_llvmContext, "loopLatch", func);
+    llvm::BasicBlock* finalBlock = llvm::BasicBlock::Create(*m_llvmContext, "loopExit", func);
+    m_IRBuilder->CreateBr(headerBlock);
+    m_IRBuilder->SetInsertPoint(headerBlock);
+    llvm::Value* index = m_IRBuilder->CreateLoad(m_intType, counterVariable);
+    m_IRBuilder->CreateCondBr(m_IRBuilder->CreateICmpSLT(index, func->getArg(2)), bodyBlock, finalBlock);
+
+    m_IRBuilder->SetInsertPoint(bodyBlock);
+    for(ast::Statement* stmnt: whileLoop.m_stmnts){
+        genInstruction(*stmnt);
+    }
+    m_IRBuilder->CreateBr(latchBlock);
+    m_IRBuilder->SetInsertPoint(latchBlock);
+    llvm::BranchInst* backEdge = m_IRBuilder->CreateBr(headerBlock);
+    backEdge->setMetadata(llvm::LLVMContext::MD_loop, createLoopMetadata(whileLoop.m_hints));
+    m_IRBuilder->SetInsertPoint(finalBlock);
+    m_IRBuilder->CreateRetVoid();
+
+    if(m_debugScope != nullptr){
+        m_debugBuilder->finalizeSubprogram(m_debugScope);
+    }
+    m_variables = std::move(variables);
+    m_parameters = std::move(parameters);
+    m_functionBody = functionBody;
+    m_debugScope = debugScope;
+    return func;
+}
+
+llvm::MDNode* LlvmIRGenerator::createLoopMetadata(const ast::LoopHints& loopHints){
+    auto createHint = [&](const char* name, llvm::Metadata* value)->llvm::MDNode*{
+        llvm::Metadata* operands[] = {llvm::MDString::get(*m_llvmContext, name), value};
+        return llvm::MDNode::get(*m_llvmContext, operands);
+    };
+    auto createInt = [&](int value)->llvm::Metadata*{
+        return llvm::ConstantAsMetadata::get(m_IRBuilder->getInt32(value));
+    };
+    // first operand is the loop id itself, it is replaced after the node is created
+    std::vector<llvm::Metadata*> properties = {nullptr};
+    if(loopHints.m_unroll){
+        if(loopHints.m_unrollCount > 0){
+            properties.push_back(createHint("llvm.loop.unroll.count", createInt(loopHints.m_unrollCount)));
+        }else{
+            properties.push_back(llvm::MDNode::get(*m_llvmContext, llvm::MDString::get(*m_llvmContext, "llvm.loop.unroll.enable")));
+        }
+    }
+    if(loopHints.m_vectorize){
+        properties.push_back(createHint("llvm.loop.vectorize.enable", llvm::ConstantAsMetadata::get(m_IRBuilder->getTrue())));
+        if(loopHints.m_vectorizeWidth > 0){
+            properties.push_back(createHint("llvm.loop.vectorize.width", createInt(loopHints.m_vectorizeWidth)));
+        }
+    }
+    llvm::MDNode* loopID = llvm::MDNode::getDistinct(*m_llvmContext, properties);
+    loopID->replaceOperandWith(0, loopID);
+    return loopID;
+}
+
 void LlvmIRGenerator::genInstruction(ast::Statement& statement){
+    setDebugLocation(findLineNumber(statement));
     switch (statement.m_type) {
 
         case ast::Statement::Type::DECLARATIVE:
@@ -371,34 +1575,95 @@ void LlvmIRGenerator::genInstruction(ast::Statement& statement){
     };
 }
 
-llvm::Function* LlvmIRGenerator::genFunction(ast::Function& function){
-    const std::string identifier(function.m_identifier->m_value, function.m_identifier->m_valueSize);
+llvm::FunctionType* LlvmIRGenerator::getFunctionType(ast::Function& function){
     llvm::Type* returnType = getType(*function.m_returnType);
-    llvm::FunctionType* funcType;
     if(function.m_parameters.empty()){
-        funcType = llvm::FunctionType::get(returnType, false);
-    }else{
-        std::vector<llvm::Type*> paramsType;
-        for(ast::Parameter param : function.m_parameters){
-            llvm::Type* paramType = getType(*param.m_dataType);
-            paramsType.push_back(paramType);
+        return llvm::FunctionType::get(returnType, false);
+    }
+    std::vector<llvm::Type*> paramsType;
+    for(ast::Parameter param : function.m_parameters){
+        llvm::Type* paramType = getType(param);
+        paramsType.push_back(paramType);
+    }
+    return llvm::FunctionType::get(returnType, llvm::ArrayRef<llvm::Type*>(paramsType), false);
+}
+
+/*
+    The analyzer never lets one array reach two parameters of a call and arrays cannot be stored,
+    so array parameters are noalias and nocapture, which lets loops over them be vectorized without runtime checks.
+*/
+void LlvmIRGenerator::addParamAttributes(llvm::Function* func, ast::Function& function){
+    const llvm::DataLayout& dataLayout = m_module->getDataLayout();
+    std::list<ast::Parameter>::iterator param = function.m_parameters.begin();
+    for(llvm::Argument& arg: func->args()){
+        if(param->m_arraySize != 0){
+            llvm::Type* elementType = getType(*param->m_dataType);
+            // a mutable global array of the same type may be passed in while the function also uses it directly
+            llvm::ArrayType* arrayType = llvm::ArrayType::get(elementType, param->m_arraySize);
+            const bool mayAliasGlobal = std::any_of(m_globals.begin(), m_globals.end(), [&](const auto& global){
+                return !global.second->isConstant() && global.second->getValueType() == arrayType;
+            });
+            if(!mayAliasGlobal){
+                arg.addAttr(llvm::Attribute::NoAlias);
+            }
+            arg.addAttr(llvm::Attribute::NoCapture);
+            arg.addAttr(llvm::Attribute::getWithDereferenceableBytes(*m_llvmContext, dataLayout.getTypeAllocSize(elementType) * param->m_arraySize));
+            arg.addAttr(llvm::Attribute::getWithAlignment(*m_llvmContext, dataLayout.getABITypeAlign(elementType)));
         }
-        funcType = llvm::FunctionType::get(returnType, llvm::ArrayRef<llvm::Type*>(paramsType), false);
+        param++;
+    }
+}
+
+// lets the optimizer cost and vectorize for the selected cpu, functions from other modules keep their own
+void LlvmIRGenerator::setTargetAttributes(llvm::Function* func){
+    func->addFnAttr("target-cpu", m_targetMachine->getTargetCPU());
+    if(!m_targetMachine->getTargetFeatureString().empty()){
+        func->addFnAttr("target-features", m_targetMachine->getTargetFeatureString());
     }
+}
+
+llvm::Function* LlvmIRGenerator::genFunction(ast::Function& function){
+    const std::string identifier(function.m_identifier->m_value, function.m_identifier->m_valueSize);
+    llvm::FunctionType* funcType = getFunctionType(function);
     llvm::Function* func = llvm::Function::Create(funcType, llvm::GlobalValue::ExternalLinkage, identifier, *m_module);
+    addParamAttributes(func, function);
+    // the body of a memo function is called by a wrapper on table misses, recursive calls go through the wrapper
+    llvm::Function* memoFunc = nullptr;
+    if(function.m_isMemo){
+        memoFunc = func;
+        func = llvm::Function::Create(funcType, llvm::GlobalValue::InternalLinkage, identifier + ".body", *m_module);
+    }
 
-    llvm::BasicBlock* entryBlock = llvm::BasicBlock::Create(*llvmContext, "entry", func);
+    llvm::BasicBlock* entryBlock = llvm::BasicBlock::Create(*m_llvmContext, "entry", func);
     m_IRBuilder->SetInsertPoint(entryBlock);
+    if(m_debugBuilder != nullptr){
+        const uint32_t lineNumber = function.m_identifier->m_lineNumber;
+        m_debugScope = m_debugBuilder->createFunction(m_debugFile, identifier, llvm::StringRef(), m_debugFile, lineNumber,
+                getDebugFunctionType(function), lineNumber, llvm::DINode::FlagPrototyped, llvm::DISubprogram::SPFlagDefinition);
+        func->setSubprogram(m_debugScope);
+        // profilers walk the stack through frame pointers
+        func->addFnAttr("frame-pointer", "all");
+        setDebugLocation(lineNumber);
+    }
+    setTargetAttributes(func);
     std::list<ast::Parameter>::iterator param = function.m_parameters.begin();
     for(llvm::Argument& arg: func->args()){
         std::string_view argName(param->m_identifier->m_value, param->m_identifier->m_valueSize);
         llvm::Type* type = arg.getType();
-        llvm::AllocaInst* variable = m_IRBuilder->CreateAlloca(type, nullptr, argName); 
-        
+        llvm::AllocaInst* variable = createEntryBlockAlloca(type, argName);
+        declareDebugVariable(variable, *param->m_identifier, param->m_dataType->m_tokenType.keywordType, param->m_arraySize, arg.getArgNo() + 1);
+        if(param->m_arraySize != 0){
+            m_arrayTypes.insert({argName, llvm::ArrayType::get(getType(*param->m_dataType), param->m_arraySize)});
+        }
+
         m_IRBuilder->CreateStore(&arg, variable); 
         m_variables.insert({argName, variable});
+        m_parameters.push_back(variable);
         param++;
     }
+    m_functionBody = llvm::BasicBlock::Create(*m_llvmContext, "body", func);
+    m_IRBuilder->CreateBr(m_functionBody);
+    m_IRBuilder->SetInsertPoint(m_functionBody);
     for(ast::Statement* statement: function.m_statements){
         genInstruction(*statement);
         if(statement->m_type == ast::Statement::Type::RETURN){
@@ -406,5 +1671,109 @@ llvm::Function* LlvmIRGenerator::genFunction(ast::Function& function){
         }
     }
     m_variables.clear();
+    m_arrayTypes.clear();
+    m_parameters.clear();
+    m_functionBody = nullptr;
+    if(m_debugScope != nullptr){
+        m_debugBuilder->finalizeSubprogram(m_debugScope);
+        m_debugScope = nullptr;
+        m_IRBuilder->SetCurrentDebugLocation(llvm::DebugLoc());
+    }
+    if(memoFunc != nullptr){
+        genMemoFunction(memoFunc, func);
+        return memoFunc;
+    }
     return func;
+}
+
+/*
+    Memo table is a direct mapped array of slots {sequence, arguments..., result} indexed by a hash of the arguments,
+    a colliding call replaces the slot. Sequence is 0 for an empty slot and odd while a slot is written so that
+    calls from parallel loops never read a torn slot, a writer that loses the race skips the insert.
+*/
+void LlvmIRGenerator::genMemoFunction(llvm::Function* func, llvm::Function* body){
+    std::vector<llvm::Type*> fields{m_intType};
+    for(llvm::Argument& arg: func->args()){
+        fields.push_back(arg.getType());
+    }
+    fields.push_back(func->getReturnType());
+    llvm::StructType* slotType = llvm::StructType::get(*m_llvmContext, fields);
+    const uint64_t slotSize = m_module->getDataLayout().getTypeAllocSize(slotType);
+    uint32_t indexBits = 0;
+    while(!func->arg_empty() && indexBits < 30 && (slotSize << (indexBits + 1)) <= m_memoCapacity){
+        indexBits++;
+    }
+    llvm::ArrayType* tableType = llvm::ArrayType::get(slotType, uint64_t(1) << indexBits);
+    llvm::GlobalVariable* table = new llvm::GlobalVariable(*m_module, tableType, false, llvm::GlobalValue::InternalLinkage,
+            llvm::ConstantAggregateZero::get(tableType), func->getName() + ".memo");
+    setTargetAttributes(func);
+
+    llvm::BasicBlock* entryBlock = llvm::BasicBlock::Create(*m_llvmContext, "entry", func);
+    llvm::BasicBlock* hitBlock = llvm::BasicBlock::Create(*m_llvmContext, "hit", func);
+    llvm::BasicBlock* missBlock = llvm::BasicBlock::Create(*m_llvmContext, "miss", func);
+    llvm::BasicBlock* claimBlock = llvm::BasicBlock::Create(*m_llvmContext, "claim", func);
+    llvm::BasicBlock* insertBlock = llvm::BasicBlock::Create(*m_llvmContext, "insert", func);
+    llvm::BasicBlock* exitBlock = llvm::BasicBlock::Create(*m_llvmContext, "exit", func);
+    m_IRBuilder->SetInsertPoint(entryBlock);
+
+    // fibonacci hashing, the top bits of the product are the best mixed
+    llvm::Value* hash = m_IRBuilder->getInt32(0);
+    std::vector<llvm::Value*> args;
+    for(llvm::Argument& arg: func->args()){
+        args.push_back(&arg);
+        hash = m_IRBuilder->CreateXor(hash, m_IRBuilder->CreateZExt(&arg, m_intType));
+        hash = m_IRBuilder->CreateMul(hash, m_IRBuilder->getInt32(0x9E3779B1));
+    }
+    llvm::Value* index = indexBits == 0 ? m_IRBuilder->getInt32(0) : m_IRBuilder->CreateLShr(hash, 32 - indexBits);
+    llvm::Value* slot = m_IRBuilder->CreateInBoundsGEP(tableType, table, {m_IRBuilder->getInt32(0), index}, "slot");
+    llvm::Value* sequencePtr = m_IRBuilder->CreateStructGEP(slotType, slot, 0);
+    auto loadField = [&](llvm::Value* fieldPtr, llvm::Type* type, llvm::AtomicOrdering ordering){
+        llvm::LoadInst* load = m_IRBuilder->CreateLoad(type, fieldPtr);
+        load->setAtomic(ordering);
+        return load;
+    };
+    auto storeField = [&](llvm::Value* value, llvm::Value* fieldPtr, llvm::AtomicOrdering ordering){
+        llvm::StoreInst* store = m_IRBuilder->CreateStore(value, fieldPtr);
+        store->setAtomic(ordering);
+    };
+
+    llvm::Value* sequence = loadField(sequencePtr, m_intType, llvm::AtomicOrdering::Acquire);
+    llvm::Value* isHit = m_IRBuilder->CreateAnd(m_IRBuilder->CreateICmpNE(sequence, m_IRBuilder->getInt32(0)),
+            m_IRBuilder->CreateICmpEQ(m_IRBuilder->CreateAnd(sequence, 1), m_IRBuilder->getInt32(0)));
+    for(size_t i=0;i<args.size();i++){
+        llvm::Value* key = loadField(m_IRBuilder->CreateStructGEP(slotType, slot, i + 1), fields[i + 1], llvm::AtomicOrdering::Monotonic);
+        isHit = m_IRBuilder->CreateAnd(isHit, m_IRBuilder->CreateICmpEQ(key, args[i]));
+    }
+    llvm::Value* resultPtr = m_IRBuilder->CreateStructGEP(slotType, slot, args.size() + 1);
+    llvm::Value* cachedResult = loadField(resultPtr, func->getReturnType(), llvm::AtomicOrdering::Monotonic);
+    m_IRBuilder->CreateFence(llvm::AtomicOrdering::Acquire);
+    llvm::Value* sequenceAfter = loadField(sequencePtr, m_intType, llvm::AtomicOrdering::Monotonic);
+    isHit = m_IRBuilder->CreateAnd(isHit, m_IRBuilder->CreateICmpEQ(sequence, sequenceAfter));
+    m_IRBuilder->CreateCondBr(isHit, hitBlock, missBlock);
+
+    m_IRBuilder->SetInsertPoint(hitBlock);
+    m_IRBuilder->CreateRet(cachedResult);
+
+    m_IRBuilder->SetInsertPoint(missBlock);
+    llvm::Value* result = m_IRBuilder->CreateCall(body, args);
+    // the body may have filled this slot through recursion, so the sequence is read again
+    llvm::Value* current = loadField(sequencePtr, m_intType, llvm::AtomicOrdering::Monotonic);
+    m_IRBuilder->CreateCondBr(m_IRBuilder->CreateICmpEQ(m_IRBuilder->CreateAnd(current, 1), m_IRBuilder->getInt32(0)), claimBlock, exitBlock);
+
+    m_IRBuilder->SetInsertPoint(claimBlock);
+    llvm::Value* exchange = m_IRBuilder->CreateAtomicCmpXchg(sequencePtr, current, m_IRBuilder->CreateAdd(current, m_IRBuilder->getInt32(1)),
+            llvm::MaybeAlign(), llvm::AtomicOrdering::Acquire, llvm::AtomicOrdering::Monotonic);
+    m_IRBuilder->CreateCondBr(m_IRBuilder->CreateExtractValue(exchange, 1), insertBlock, exitBlock);
+
+    m_IRBuilder->SetInsertPoint(insertBlock);
+    m_IRBuilder->CreateFence(llvm::AtomicOrdering::Release);
+    for(size_t i=0;i<args.size();i++){
+        storeField(args[i], m_IRBuilder->CreateStructGEP(slotType, slot, i + 1), llvm::AtomicOrdering::Monotonic);
+    }
+    storeField(result, resultPtr, llvm::AtomicOrdering::Monotonic);
+    storeField(m_IRBuilder->CreateAdd(current, m_IRBuilder->getInt32(2)), sequencePtr, llvm::AtomicOrdering::Release);
+    m_IRBuilder->CreateBr(exitBlock);
+
+    m_IRBuilder->SetInsertPoint(exitBlock);
+    m_IRBuilder->CreateRet(result);
 }
\ No newline at end of file
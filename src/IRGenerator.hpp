@@ -1,21 +1,73 @@
 #pragma once
 #include "AST.hpp"
 #include "SymbolTableHandler.hpp"
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/DIBuilder.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Support/CodeGen.h>
+#include <llvm/Support/raw_ostream.h>
 #include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
+
+enum class OptimizationLevel{
+    O0,
+    O1,
+    O2,
+    O3
+};
+
+enum class ProfileMode{
+    NONE,
+    GENERATE, // instrument the program to write a raw profile when it exits
+    USE // optimize using branch weights and entry counts from a profile
+};
 
 class IRGenerator{
 
 public:
     virtual void generate(const ast::File& syntaxTree) = 0;
+    // emits dwarf debug info for the given source file and keeps frame pointers, must be called before generate
+    virtual void enableDebugInfo(const std::filesystem::path& sourceFile) = 0;
+    // selects the cpu code is generated for, "native" is the host cpu, must be called before generate
+    virtual void setTargetCpu(const std::string& cpu) = 0;
+    // array indexes out of bounds trap at runtime, must be called before generate
+    virtual void enableBoundsChecks() = 0;
+    // bytes of the result table of each memo function
+    virtual void setMemoCapacity(uint64_t bytes) = 0;
+    // declares a function defined in another module so that it can be called from this one
+    virtual void declare(ast::Function& function) = 0;
+    // creates an independent generator of the same kind, modules can be generated on separate threads
+    virtual std::unique_ptr<IRGenerator> createModuleGenerator(const std::string& moduleName) const = 0;
+    virtual void emitBitcode(std::vector<char>& buffer) = 0;
+    virtual void linkBitcode(const std::vector<char>& buffer, const std::string& moduleName) = 0;
+    virtual void optimize(OptimizationLevel optimizationLevel) = 0;
+    // applied by the next optimize
+    virtual void setProfile(ProfileMode profileMode, const std::filesystem::path& profileFile) = 0;
+    // links the bitcode build of the standard library into the module, so its functions can be optimized along with the program
+    virtual void linkStandardLibrary(const std::filesystem::path& bitcodeFile) = 0;
+    // treats the module as the whole program, only main stays visible outside of it
+    virtual void internalize() = 0;
+    virtual void loadFromFile(const std::filesystem::path& inputFile) = 0;
     virtual void saveToFile(const std::filesystem::path& outputFile) = 0;
+    virtual void saveBitcodeToFile(const std::filesystem::path& outputFile) = 0;
+    virtual void emitAssembly(const std::filesystem::path& outputFile) = 0;
+    virtual void emitObject(const std::filesystem::path& outputFile) = 0;
+    virtual void emitObject(std::vector<char>& buffer) = 0;
+    // splits the module into at most partitionCount objects which are emitted in parallel
+    virtual void emitObjects(std::vector<std::vector<char>>& buffers, unsigned int partitionCount) = 0;
+    virtual int run() = 0;
+    virtual ~IRGenerator() = default;
 };
 
 class LlvmIRGenerator: public IRGenerator{
@@ -24,19 +76,68 @@ public:
     LlvmIRGenerator(const std::string& modulename);
 
     void generate(const ast::File& syntaxTree) override;
+    void enableDebugInfo(const std::filesystem::path& sourceFile) override;
+    void setTargetCpu(const std::string& cpu) override;
+    void enableBoundsChecks() override;
+    void setMemoCapacity(uint64_t bytes) override;
+    void declare(ast::Function& function) override;
+    std::unique_ptr<IRGenerator> createModuleGenerator(const std::string& moduleName) const override;
+    void emitBitcode(std::vector<char>& buffer) override;
+    void linkBitcode(const std::vector<char>& buffer, const std::string& moduleName) override;
+    void optimize(OptimizationLevel optimizationLevel) override;
+    void setProfile(ProfileMode profileMode, const std::filesystem::path& profileFile) override;
+    void linkStandardLibrary(const std::filesystem::path& bitcodeFile) override;
+    void internalize() override;
+    void loadFromFile(const std::filesystem::path& inputFile) override;
     void saveToFile(const std::filesystem::path& outputfile) override;
+    void saveBitcodeToFile(const std::filesystem::path& outputFile) override;
+    void emitAssembly(const std::filesystem::path& outputFile) override;
+    void emitObject(const std::filesystem::path& outputFile) override;
+    void emitObject(std::vector<char>& buffer) override;
+    void emitObjects(std::vector<std::vector<char>>& buffers, unsigned int partitionCount) override;
+    // jit compiles the module and calls main, generator cannot be used afterwards
+    int run() override;
 
 private:
     void init(const std::string& inputFile);
+    void initTargetMachine(const std::string& cpu = "generic", const std::string& features = "");
+    std::unique_ptr<llvm::TargetMachine> cloneTargetMachine() const;
+    void runPipeline(const std::function<llvm::ModulePassManager(llvm::PassBuilder&)>& buildPipeline,
+            llvm::Optional<llvm::PGOOptions> pgoOptions = llvm::None);
+    llvm::Optional<llvm::PGOOptions> createPGOOptions();
+    void emitFile(llvm::raw_pwrite_stream& output, llvm::CodeGenFileType fileType);
+    void emitFile(const std::filesystem::path& outputFile, llvm::CodeGenFileType fileType);
     void includeStandardLibFuncPrototype();
     llvm::Function* genFunction(ast::Function& function);
+    llvm::FunctionType* getFunctionType(ast::Function& function);
+    void addParamAttributes(llvm::Function* func, ast::Function& function);
+    llvm::AllocaInst* createEntryBlockAlloca(llvm::Type* type, std::string_view name);
     llvm::Type* getType(Token& typeToken);
     llvm::Type* getType(Keyword type);
+    llvm::Type* getType(const ast::Parameter& param);
+    llvm::DIType* getDebugType(Keyword type);
+    llvm::DIType* getDebugType(Keyword type, uint32_t arraySize, bool isParameter);
+    llvm::DISubroutineType* getDebugFunctionType(ast::Function& function);
+    void setDebugLocation(uint32_t lineNumber);
+    void declareDebugVariable(llvm::AllocaInst* variable, const Token& identifier, Keyword type, uint32_t arraySize, uint32_t argNumber);
     llvm::Value* computeExpression(ast::Expression& expr);
+    llvm::Value* toCondition(llvm::Value* value);
+    void genCondition(ast::Expression& expr, llvm::BasicBlock* onTrue, llvm::BasicBlock* onFalse);
+    void genCondition(ast::Expression& expr, std::vector<ast::ExpressionTail*>& exprTails, size_t size, llvm::BasicBlock* onTrue, llvm::BasicBlock* onFalse);
     llvm::Value* computeRelational(ast::Relational& relational);
     llvm::Value* computeAdditive(ast::Additive& additive);
     llvm::Value* computeTerm(ast::Term& term);
     llvm::Value* getFactor(ast::Factor& factor);
+    llvm::Value* getVariable(std::string_view name, llvm::Type*& type);
+    llvm::ArrayType* findArrayType(std::string_view name) const;
+    llvm::Value* getArray(const Token& identifier);
+    llvm::Value* getArrayElement(const Token& identifier, ast::Expression& index);
+    llvm::Value* getLaneIndex(llvm::FixedVectorType* vectorType, ast::Expression& index);
+    llvm::Value* broadcast(llvm::Value* value, llvm::Type* type);
+    void matchOperands(llvm::Value*& lhs, llvm::Value*& rhs);
+    llvm::Value* genVectorReduction(std::string_view reduction, llvm::Value* vector);
+    void genBoundsCheck(llvm::Value* index, uint64_t size);
+    bool passesLocalArray(const ast::FunctionCallStatement& functionCallStatement);
 
     void genInstruction(ast::Statement& statement);
     void importFiles(std::list<Token*>& importPackages);
@@ -44,17 +145,46 @@ private:
     void genInstruction(ast::AssignmentStatement& declarativeStatement);
     void genInstruction(ast::ReturnStatement& returnStatement);
     void genInstruction(ast::ConditionalStatement& conditionalStatement, llvm::BasicBlock* finalBlock);
+    bool genSwitch(ast::ConditionalStatement& conditionalStatement);
+    void genBranchBody(std::list<ast::Statement*>& stmnts, llvm::BasicBlock* finalBlock);
     void genInstruction(ast::WhileLoop& whileLoop);
+    void genParallelLoop(ast::WhileLoop& whileLoop);
+    llvm::Function* genParallelBody(ast::WhileLoop& whileLoop, const std::vector<std::pair<std::string_view, llvm::Type*>>& captures,
+            llvm::StructType* contextType);
+    void genGlobal(ast::DeclarativeStatement& declarativeStatement);
+    void genArrayInitializer(ast::DeclarativeStatement& declarativeStatement, llvm::AllocaInst* variable);
+    void setTargetAttributes(llvm::Function* func);
+    void genMemoFunction(llvm::Function* func, llvm::Function* body);
+    llvm::MDNode* createLoopMetadata(const ast::LoopHints& loopHints);
     llvm::Value* genInstruction(ast::FunctionCallStatement& functionCallStatement);
+    void genSelfTailCall(ast::FunctionCallStatement& functionCallStatement);
+
+    std::unordered_map<std::string_view, llvm::AllocaInst*> m_variables;
+    // local arrays are allocated in place, array parameters are pointers to the caller's array
+    std::unordered_map<std::string_view, llvm::ArrayType*> m_arrayTypes;
+    // globals of the file being generated
+    std::unordered_map<std::string_view, llvm::GlobalVariable*> m_globals;
+    bool m_boundsChecks = false;
+    uint64_t m_memoCapacity = 1 << 20;
+    // parameters of the function being generated, a self call in tail position reassigns them and jumps to its body
+    std::vector<llvm::AllocaInst*> m_parameters;
+    llvm::BasicBlock* m_functionBody = nullptr;
+
+    ProfileMode m_profileMode = ProfileMode::NONE;
+    std::filesystem::path m_profileFile;
 
-    std::unordered_map<std::string_view, llvm::AllocaInst*> m_variables;    
+    // only set when debug info is enabled
+    std::unique_ptr<llvm::DIBuilder> m_debugBuilder;
+    llvm::DIFile* m_debugFile = nullptr;
+    llvm::DISubprogram* m_debugScope = nullptr;    
 
+    std::unique_ptr<llvm::LLVMContext> m_llvmContext;
     std::unique_ptr<llvm::Module> m_module;
     std::unique_ptr<llvm::IRBuilder<>> m_IRBuilder;
+    std::unique_ptr<llvm::TargetMachine> m_targetMachine;
 
-    static std::unique_ptr<llvm::LLVMContext> llvmContext;
-    static llvm::Type* intType;
-    static llvm::Type* charType;
-    static llvm::Type* floatType;
-    static llvm::Type* voidType;
+    llvm::Type* m_intType;
+    llvm::Type* m_charType;
+    llvm::Type* m_floatType;
+    llvm::Type* m_voidType;
 };
\ No newline at end of file
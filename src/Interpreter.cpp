@@ -0,0 +1,605 @@
+#include "Interpreter.hpp"
+#include "AST.hpp"
+#include "ConstantValue.hpp"
+#include "Token.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace{
+
+// true when predicate holds for a factor of the expression, including the ones in call arguments and array indexes
+bool anyFactor(const ast::Expression& expression, const std::function<bool(const ast::Factor&)>& predicate){
+    auto inFactor = [&](const ast::Factor& factor){
+        if(predicate(factor)){
+            return true;
+        }
+        switch(factor.operandType){
+            case ast::Factor::OperandType::EXPR:
+                return anyFactor(*factor.operand.expression, predicate);
+            case ast::Factor::OperandType::FUNCTION_CALL:
+                for(const ast::Expression* arg: factor.operand.functionCall->m_args){
+                    if(anyFactor(*arg, predicate)){
+                        return true;
+                    }
+                }
+                return false;
+            case ast::Factor::OperandType::ARRAY_ACCESS:
+                return anyFactor(*factor.operand.arrayAccess->m_index, predicate);
+            default:
+                return false;
+        }
+    };
+    auto inTerm = [&](const ast::Term& term){
+        bool isFound = inFactor(*term.m_factor);
+        for(const ast::TermTail* termTail = term.m_termTail; !isFound && termTail != nullptr; termTail = termTail->m_termTail){
+            isFound = inFactor(*termTail->m_factor);
+        }
+        return isFound;
+    };
+    auto inAdditive = [&](const ast::Additive& additive){
+        bool isFound = inTerm(*additive.m_term);
+        for(const ast::AdditiveTail* additiveTail = additive.m_additiveTail; !isFound && additiveTail != nullptr; additiveTail = additiveTail->m_additiveTail){
+            isFound = inTerm(*additiveTail->m_term);
+        }
+        return isFound;
+    };
+    auto inRelational = [&](const ast::Relational& relational){
+        bool isFound = inAdditive(*relational.m_additive);
+        for(const ast::RelationalTail* relationalTail = relational.m_relationalTail; !isFound && relationalTail != nullptr; relationalTail = relationalTail->m_relationalTail){
+            isFound = inAdditive(*relationalTail->m_additive);
+        }
+        return isFound;
+    };
+    bool isFound = inRelational(*expression.m_relational);
+    for(const ast::ExpressionTail* exprTail = expression.m_expressionTail; !isFound && exprTail != nullptr; exprTail = exprTail->m_expressionTail){
+        isFound = inRelational(*exprTail->m_relational);
+    }
+    return isFound;
+}
+
+}
+
+Interpreter::Interpreter(const std::list<ast::Function*>& functions, const std::list<ast::DeclarativeStatement*>& globals){
+    for(ast::Function* function: functions){
+        std::string_view identifier(function->m_identifier->m_value, function->m_identifier->m_valueSize);
+        m_functions.insert({identifier, function});
+    }
+    for(ast::DeclarativeStatement* global: globals){
+        std::string_view identifier(global->m_identifier->m_value, global->m_identifier->m_valueSize);
+        m_globals.insert(identifier);
+        if(global->m_arraySize != 0){
+            m_globalArrays.insert(identifier);
+        }
+    }
+}
+
+bool Interpreter::isGlobal(const Token& identifier) const{
+    return identifier.m_tokenType.type == Type::IDENTIFIER && m_globals.count(std::string_view(identifier.m_value, identifier.m_valueSize)) != 0;
+}
+
+bool Interpreter::isGlobalArray(const Token& identifier) const{
+    return identifier.m_tokenType.type == Type::IDENTIFIER && m_globalArrays.count(std::string_view(identifier.m_value, identifier.m_valueSize)) != 0;
+}
+
+bool Interpreter::evaluate(const ast::FunctionCallStatement& functionCall, const std::vector<ConstantValue>& args, ConstantValue& result){
+    const ast::Function* function = findFunction(*functionCall.m_identifier);
+    if(function == nullptr || !isPure(*function)){
+        return false;
+    }
+    m_remainingSteps = MAX_STEPS;
+    bool isEvaluated = callFunction(*function, args, result);
+    m_frames.clear();
+    return isEvaluated;
+}
+
+bool Interpreter::consumeStep(){
+    return --m_remainingSteps >= 0;
+}
+
+const ast::Function* Interpreter::findFunction(const Token& identifier) const{
+    std::string_view functionName(identifier.m_value, identifier.m_valueSize);
+    auto it = m_functions.find(functionName);
+    if(it == m_functions.end()){
+        return nullptr;
+    }
+    return it->second;
+}
+
+ConstantValue* Interpreter::findVariable(const Token& identifier){
+    std::string_view varName(identifier.m_value, identifier.m_valueSize);
+    std::list<Scope>& scopes = m_frames.back();
+    for(auto scope = scopes.rbegin(); scope != scopes.rend(); scope++){
+        auto it = scope->find(varName);
+        if(it != scope->end()){
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+bool Interpreter::callFunction(const ast::Function& function, const std::vector<ConstantValue>& args, ConstantValue& result){
+    if(m_frames.size() == static_cast<size_t>(MAX_CALL_DEPTH) || args.size() != function.m_parameters.size()){
+        return false;
+    }
+    m_frames.emplace_back();
+    m_frames.back().emplace_back();
+    Scope& paramScope = m_frames.back().back();
+    auto arg = args.begin();
+    for(const ast::Parameter& param: function.m_parameters){
+        std::string_view paramName(param.m_identifier->m_value, param.m_identifier->m_valueSize);
+        paramScope.insert({paramName, *arg});
+        arg++;
+    }
+    Status status = execute(function.m_statements, result);
+    m_frames.pop_back();
+    return status == Status::RETURN && result.dataType == function.m_returnType->m_tokenType.keywordType;
+}
+
+Interpreter::Status Interpreter::execute(const std::list<ast::Statement*>& stmnts, ConstantValue& returnValue){
+    m_frames.back().emplace_back();
+    Status status = Status::NEXT;
+    for(const ast::Statement* stmnt: stmnts){
+        status = execute(*stmnt, returnValue);
+        if(status != Status::NEXT){
+            break;
+        }
+    }
+    m_frames.back().pop_back();
+    return status;
+}
+
+Interpreter::Status Interpreter::execute(const ast::Statement& statement, ConstantValue& returnValue){
+    if(!consumeStep()){
+        return Status::FAIL;
+    }
+    switch(statement.m_type){
+        case ast::Statement::Type::DECLARATIVE:
+            {
+                const ast::DeclarativeStatement& declarativeStatement = *statement.m_data.declarativeStatement;
+                std::string_view varName(declarativeStatement.m_identifier->m_value, declarativeStatement.m_identifier->m_valueSize);
+                ConstantValue value;
+                if(declarativeStatement.m_expression != nullptr && !evaluate(*declarativeStatement.m_expression, value)){
+                    return Status::FAIL;
+                }
+                m_frames.back().back().insert({varName, value});
+                return Status::NEXT;
+            }
+        case ast::Statement::Type::ASSIGNMENT:
+            {
+                const ast::AssignmentStatement& assignmentStatement = *statement.m_data.assignmentStatement;
+                ConstantValue* variable = findVariable(*assignmentStatement.m_identifier);
+                ConstantValue value;
+                if(variable == nullptr || assignmentStatement.m_index != nullptr || !evaluate(*assignmentStatement.m_expression, value)){
+                    return Status::FAIL;
+                }
+                *variable = value;
+                return Status::NEXT;
+            }
+        case ast::Statement::Type::CONDITIONAL:
+            return execute(*statement.m_data.conditionalStatement, returnValue);
+        case ast::Statement::Type::FUNCTION_CALL:
+            {
+                ConstantValue ignored;
+                if(!evaluateCall(*statement.m_data.functionalCallStatement, ignored)){
+                    return Status::FAIL;
+                }
+                return Status::NEXT;
+            }
+        case ast::Statement::Type::RETURN:
+            {
+                const ast::ReturnStatement& returnStatement = *statement.m_data.returnStatement;
+                if(returnStatement.m_expr == nullptr){
+                    returnValue.dataType = Keyword::VOID;
+                }else if(!evaluate(*returnStatement.m_expr, returnValue)){
+                    return Status::FAIL;
+                }
+                return Status::RETURN;
+            }
+        case ast::Statement::Type::WHILE_LOOP:
+            return execute(*statement.m_data.whileLoop, returnValue);
+    }
+    return Status::FAIL;
+}
+
+Interpreter::Status Interpreter::execute(const ast::ConditionalStatement& conditionalStatement, ConstantValue& returnValue){
+    const ast::ConditionalStatement* current = &conditionalStatement;
+    while(current != nullptr){
+        if(current->m_expr == nullptr){
+            return execute(current->m_stmnts, returnValue);
+        }
+        ConstantValue condition;
+        if(!evaluate(*current->m_expr, condition)){
+            return Status::FAIL;
+        }
+        if(condition.intValue != 0){
+            return execute(current->m_stmnts, returnValue);
+        }
+        current = current->m_else;
+    }
+    return Status::NEXT;
+}
+
+Interpreter::Status Interpreter::execute(const ast::WhileLoop& whileLoop, ConstantValue& returnValue){
+    while(true){
+        ConstantValue condition;
+        if(!consumeStep() || !evaluate(*whileLoop.m_expr, condition)){
+            return Status::FAIL;
+        }
+        if(condition.intValue == 0){
+            return Status::NEXT;
+        }
+        Status status = execute(whileLoop.m_stmnts, returnValue);
+        if(status != Status::NEXT){
+            return status;
+        }
+    }
+}
+
+bool Interpreter::evaluateCall(const ast::FunctionCallStatement& functionCall, ConstantValue& result){
+    const ast::Function* function = findFunction(*functionCall.m_identifier);
+    if(function == nullptr){
+        return false;
+    }
+    std::vector<ConstantValue> args;
+    for(const ast::Expression* arg: functionCall.m_args){
+        ConstantValue value;
+        if(!evaluate(*arg, value)){
+            return false;
+        }
+        args.push_back(value);
+    }
+    return callFunction(*function, args, result);
+}
+
+/*
+    Relational and logical operators produce int 0 or 1, the same
+    representation is used for conditions of if and while.
+*/
+bool Interpreter::evaluate(const ast::Expression& expression, ConstantValue& result){
+    if(!evaluate(*expression.m_relational, result)){
+        return false;
+    }
+    const ast::ExpressionTail* exprTail = expression.m_expressionTail;
+    while(exprTail != nullptr){
+        ConstantValue rhs;
+        if(!evaluate(*exprTail->m_relational, rhs)){
+            return false;
+        }
+        bool value = (exprTail->m_opcode == ast::Opcode::LOGICAL_AND)
+            ? (result.intValue != 0 && rhs.intValue != 0)
+            : (result.intValue != 0 || rhs.intValue != 0);
+        result.dataType = Keyword::INT;
+        result.intValue = value;
+        exprTail = exprTail->m_expressionTail;
+    }
+    return true;
+}
+
+bool Interpreter::evaluate(const ast::Relational& relational, ConstantValue& result){
+    if(!evaluate(*relational.m_additive, result)){
+        return false;
+    }
+    const ast::RelationalTail* relationalTail = relational.m_relationalTail;
+    while(relationalTail != nullptr){
+        ConstantValue rhs;
+        bool value;
+        if(!evaluate(*relationalTail->m_additive, rhs) || !constant::compare(relationalTail->m_opcode, result, rhs, value)){
+            return false;
+        }
+        result.dataType = Keyword::INT;
+        result.intValue = value;
+        relationalTail = relationalTail->m_relationalTail;
+    }
+    return true;
+}
+
+bool Interpreter::evaluate(const ast::Additive& additive, ConstantValue& result){
+    if(!evaluate(*additive.m_term, result)){
+        return false;
+    }
+    const ast::AdditiveTail* additiveTail = additive.m_additiveTail;
+    while(additiveTail != nullptr){
+        ConstantValue rhs;
+        if(!evaluate(*additiveTail->m_term, rhs) || !constant::evaluate(additiveTail->m_opcode, result, rhs, result)){
+            return false;
+        }
+        additiveTail = additiveTail->m_additiveTail;
+    }
+    return true;
+}
+
+bool Interpreter::evaluate(const ast::Term& term, ConstantValue& result){
+    if(!evaluate(*term.m_factor, result)){
+        return false;
+    }
+    const ast::TermTail* termTail = term.m_termTail;
+    while(termTail != nullptr){
+        ConstantValue rhs;
+        if(!evaluate(*termTail->m_factor, rhs) || !constant::evaluate(termTail->m_opcode, result, rhs, result)){
+            return false;
+        }
+        termTail = termTail->m_termTail;
+    }
+    return true;
+}
+
+bool Interpreter::evaluate(const ast::Factor& factor, ConstantValue& result){
+    if(!consumeStep()){
+        return false;
+    }
+    switch(factor.operandType){
+        case ast::Factor::OperandType::VALUE:
+            {
+                const Token& value = *factor.operand.value;
+                if(value.m_tokenType.type != Type::IDENTIFIER){
+                    return constant::fromLiteral(value, result);
+                }
+                // uninitialized variables keep NIL type and are never folded
+                ConstantValue* variable = findVariable(value);
+                if(variable == nullptr || variable->dataType == Keyword::NIL){
+                    return false;
+                }
+                result = *variable;
+                return true;
+            }
+        case ast::Factor::OperandType::EXPR:
+            return evaluate(*factor.operand.expression, result);
+        case ast::Factor::OperandType::FUNCTION_CALL:
+            return evaluateCall(*factor.operand.functionCall, result);
+        case ast::Factor::OperandType::ARRAY_ACCESS:
+            return false;
+    }
+    return false;
+}
+
+/*
+    A function is pure when it only calls other pure functions defined in source.
+    Standard library functions perform io and are never pure.
+*/
+bool Interpreter::isPure(const ast::Function& function){
+    // recursive calls are assumed to be pure until the function that started the cycle is decided
+    return decide(function, m_purity, true, [&](){
+        return isPure(function.m_statements);
+    });
+}
+
+/*
+    A function writes globals when it assigns to one, passes a global array to a function (which
+    could write its elements) or calls a function that writes globals.
+*/
+bool Interpreter::writesGlobals(const ast::Function& function){
+    return decide(function, m_globalWrites, false, [&](){
+        return writesGlobals(function.m_statements);
+    });
+}
+
+/*
+    Functions reached again while they are checked get the assumed result. A result other than the
+    assumption holds whatever was assumed, the assumed one only once no assumption about a function
+    still being checked is left.
+*/
+bool Interpreter::decide(const ast::Function& function, CallGraphFacts& facts, bool assumption, const std::function<bool()>& check){
+    auto it = facts.results.find(&function);
+    if(it != facts.results.end()){
+        return it->second;
+    }
+    auto checked = std::find(facts.checks.begin(), facts.checks.end(), &function);
+    if(checked != facts.checks.end()){
+        facts.cycleStart = std::min(facts.cycleStart, static_cast<std::size_t>(checked - facts.checks.begin()));
+        return assumption;
+    }
+    const std::size_t depth = facts.checks.size();
+    facts.checks.push_back(&function);
+    bool result = check();
+    facts.checks.pop_back();
+    if(facts.cycleStart >= depth){
+        facts.cycleStart = CallGraphFacts::NO_CYCLE;
+        facts.results[&function] = result;
+    }else if(result != assumption){
+        facts.results[&function] = result;
+    }
+    return result;
+}
+
+bool Interpreter::isPure(const std::list<ast::Statement*>& stmnts){
+    for(const ast::Statement* stmnt: stmnts){
+        bool isStatementPure = true;
+        switch(stmnt->m_type){
+            case ast::Statement::Type::DECLARATIVE:
+                {
+                    const ast::DeclarativeStatement& declaration = *stmnt->m_data.declarativeStatement;
+                    isStatementPure = (declaration.m_expression == nullptr) || isPure(*declaration.m_expression);
+                    for(const ast::Expression* element: declaration.m_elements){
+                        isStatementPure = isStatementPure && isPure(*element);
+                    }
+                }
+                break;
+            case ast::Statement::Type::ASSIGNMENT:
+                // array parameters are shared with the caller, writing their elements is a side effect
+                isStatementPure = stmnt->m_data.assignmentStatement->m_index == nullptr && !isGlobal(*stmnt->m_data.assignmentStatement->m_identifier) &&
+                        isPure(*stmnt->m_data.assignmentStatement->m_expression);
+                break;
+            case ast::Statement::Type::CONDITIONAL:
+                {
+                    const ast::ConditionalStatement* current = stmnt->m_data.conditionalStatement;
+                    while(isStatementPure && current != nullptr){
+                        isStatementPure = (current->m_expr == nullptr || isPure(*current->m_expr)) && isPure(current->m_stmnts);
+                        current = current->m_else;
+                    }
+                }
+                break;
+            case ast::Statement::Type::FUNCTION_CALL:
+                isStatementPure = isPure(*stmnt->m_data.functionalCallStatement);
+                break;
+            case ast::Statement::Type::RETURN:
+                {
+                    const ast::Expression* expr = stmnt->m_data.returnStatement->m_expr;
+                    isStatementPure = (expr == nullptr) || isPure(*expr);
+                }
+                break;
+            case ast::Statement::Type::WHILE_LOOP:
+                isStatementPure = isPure(*stmnt->m_data.whileLoop->m_expr) && isPure(stmnt->m_data.whileLoop->m_stmnts);
+                break;
+        }
+        if(!isStatementPure){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Interpreter::isPure(const ast::FunctionCallStatement& functionCall){
+    const ast::Function* function = findFunction(*functionCall.m_identifier);
+    if(function == nullptr || !isPure(*function)){
+        return false;
+    }
+    for(const ast::Expression* arg: functionCall.m_args){
+        if(!isPure(*arg)){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Interpreter::writesGlobals(const std::list<ast::Statement*>& stmnts){
+    for(const ast::Statement* stmnt: stmnts){
+        bool isWriting = false;
+        switch(stmnt->m_type){
+            case ast::Statement::Type::DECLARATIVE:
+                {
+                    const ast::DeclarativeStatement& declaration = *stmnt->m_data.declarativeStatement;
+                    isWriting = declaration.m_expression != nullptr && writesGlobals(*declaration.m_expression);
+                    for(const ast::Expression* element: declaration.m_elements){
+                        isWriting = isWriting || writesGlobals(*element);
+                    }
+                }
+                break;
+            case ast::Statement::Type::ASSIGNMENT:
+                {
+                    const ast::AssignmentStatement& assignment = *stmnt->m_data.assignmentStatement;
+                    isWriting = isGlobal(*assignment.m_identifier) || writesGlobals(*assignment.m_expression) ||
+                            (assignment.m_index != nullptr && writesGlobals(*assignment.m_index));
+                }
+                break;
+            case ast::Statement::Type::CONDITIONAL:
+                for(const ast::ConditionalStatement* arm = stmnt->m_data.conditionalStatement; !isWriting && arm != nullptr; arm = arm->m_else){
+                    isWriting = (arm->m_expr != nullptr && writesGlobals(*arm->m_expr)) || writesGlobals(arm->m_stmnts);
+                }
+                break;
+            case ast::Statement::Type::FUNCTION_CALL:
+                isWriting = writesGlobals(*stmnt->m_data.functionalCallStatement);
+                break;
+            case ast::Statement::Type::RETURN:
+                {
+                    const ast::Expression* expr = stmnt->m_data.returnStatement->m_expr;
+                    isWriting = expr != nullptr && writesGlobals(*expr);
+                }
+                break;
+            case ast::Statement::Type::WHILE_LOOP:
+                isWriting = writesGlobals(*stmnt->m_data.whileLoop->m_expr) || writesGlobals(stmnt->m_data.whileLoop->m_stmnts);
+                break;
+        }
+        if(isWriting){
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Interpreter::writesGlobals(const ast::FunctionCallStatement& functionCall){
+    const ast::Function* function = findFunction(*functionCall.m_identifier);
+    if(function != nullptr && writesGlobals(*function)){
+        return true;
+    }
+    for(const ast::Expression* arg: functionCall.m_args){
+        if(writesGlobals(*arg)){
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Interpreter::writesGlobals(const ast::Expression& expression){
+    return anyFactor(expression, [&](const ast::Factor& factor){
+        switch(factor.operandType){
+            case ast::Factor::OperandType::VALUE:
+                // an array used as a whole value is being passed to a function
+                return isGlobalArray(*factor.operand.value);
+            case ast::Factor::OperandType::FUNCTION_CALL:
+                {
+                    const ast::Function* function = findFunction(*factor.operand.functionCall->m_identifier);
+                    return function != nullptr && writesGlobals(*function);
+                }
+            default:
+                return false;
+        }
+    });
+}
+
+bool Interpreter::isPure(const ast::Expression& expression){
+    if(!isPure(*expression.m_relational)){
+        return false;
+    }
+    for(const ast::ExpressionTail* exprTail = expression.m_expressionTail; exprTail != nullptr; exprTail = exprTail->m_expressionTail){
+        if(!isPure(*exprTail->m_relational)){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Interpreter::isPure(const ast::Relational& relational){
+    if(!isPure(*relational.m_additive)){
+        return false;
+    }
+    for(const ast::RelationalTail* relationalTail = relational.m_relationalTail; relationalTail != nullptr; relationalTail = relationalTail->m_relationalTail){
+        if(!isPure(*relationalTail->m_additive)){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Interpreter::isPure(const ast::Additive& additive){
+    if(!isPure(*additive.m_term)){
+        return false;
+    }
+    for(const ast::AdditiveTail* additiveTail = additive.m_additiveTail; additiveTail != nullptr; additiveTail = additiveTail->m_additiveTail){
+        if(!isPure(*additiveTail->m_term)){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Interpreter::isPure(const ast::Term& term){
+    if(!isPure(*term.m_factor)){
+        return false;
+    }
+    for(const ast::TermTail* termTail = term.m_termTail; termTail != nullptr; termTail = termTail->m_termTail){
+        if(!isPure(*termTail->m_factor)){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Interpreter::isPure(const ast::Factor& factor){
+    switch(factor.operandType){
+        case ast::Factor::OperandType::VALUE:
+            return !isGlobal(*factor.operand.value);
+        case ast::Factor::OperandType::EXPR:
+            return isPure(*factor.operand.expression);
+        case ast::Factor::OperandType::FUNCTION_CALL:
+            return isPure(*factor.operand.functionCall);
+        case ast::Factor::OperandType::ARRAY_ACCESS:
+            // result depends on memory rather than only on the arguments
+            return false;
+    }
+    return false;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "AST.hpp"
+#include "ConstantValue.hpp"
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <list>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*
+    Evaluates calls of side effect free functions at compile time.
+    Evaluation is bounded by a step and call depth budget, when any of them is
+    exceeded (or anything that cannot be evaluated is found) the call is simply left for runtime.
+*/
+class Interpreter{
+
+public:
+    Interpreter(const std::list<ast::Function*>& functions, const std::list<ast::DeclarativeStatement*>& globals);
+    bool evaluate(const ast::FunctionCallStatement& functionCall, const std::vector<ConstantValue>& args, ConstantValue& result);
+    bool isPure(const ast::Function& function);
+    bool writesGlobals(const ast::Function& function);
+    bool writesGlobals(const ast::FunctionCallStatement& functionCall);
+
+    static constexpr int MAX_STEPS = 10000;
+    static constexpr int MAX_CALL_DEPTH = 64;
+
+private:
+    using Scope = std::unordered_map<std::string_view, ConstantValue>;
+
+    enum class Status{
+        NEXT,
+        RETURN,
+        FAIL
+    };
+
+    bool callFunction(const ast::Function& function, const std::vector<ConstantValue>& args, ConstantValue& result);
+    Status execute(const std::list<ast::Statement*>& stmnts, ConstantValue& returnValue);
+    Status execute(const ast::Statement& statement, ConstantValue& returnValue);
+    Status execute(const ast::ConditionalStatement& conditionalStatement, ConstantValue& returnValue);
+    Status execute(const ast::WhileLoop& whileLoop, ConstantValue& returnValue);
+    bool evaluateCall(const ast::FunctionCallStatement& functionCall, ConstantValue& result);
+    bool evaluate(const ast::Expression& expression, ConstantValue& result);
+    bool evaluate(const ast::Relational& relational, ConstantValue& result);
+    bool evaluate(const ast::Additive& additive, ConstantValue& result);
+    bool evaluate(const ast::Term& term, ConstantValue& result);
+    bool evaluate(const ast::Factor& factor, ConstantValue& result);
+    ConstantValue* findVariable(const Token& identifier);
+    const ast::Function* findFunction(const Token& identifier) const;
+    bool consumeStep();
+
+    bool isPure(const std::list<ast::Statement*>& stmnts);
+    bool isPure(const ast::Expression& expression);
+    bool isPure(const ast::Relational& relational);
+    bool isPure(const ast::Additive& additive);
+    bool isPure(const ast::Term& term);
+    bool isPure(const ast::Factor& factor);
+    bool isPure(const ast::FunctionCallStatement& functionCall);
+    bool isGlobal(const Token& identifier) const;
+    bool isGlobalArray(const Token& identifier) const;
+
+    bool writesGlobals(const std::list<ast::Statement*>& stmnts);
+    bool writesGlobals(const ast::Expression& expression);
+
+    // results of a check over the call graph, whose cycles need an assumed result while they are checked
+    struct CallGraphFacts{
+        static constexpr std::size_t NO_CYCLE = std::numeric_limits<std::size_t>::max();
+
+        std::unordered_map<const ast::Function*, bool> results;
+        // functions being checked, outermost first
+        std::vector<const ast::Function*> checks;
+        // lowest index in checks that a pending result was assumed for
+        std::size_t cycleStart = NO_CYCLE;
+    };
+    bool decide(const ast::Function& function, CallGraphFacts& facts, bool assumption, const std::function<bool()>& check);
+
+    std::unordered_map<std::string_view, const ast::Function*> m_functions;
+    CallGraphFacts m_purity;
+    CallGraphFacts m_globalWrites;
+    // reading or writing a global depends on or changes state outside of the call
+    std::unordered_set<std::string_view> m_globals;
+    std::unordered_set<std::string_view> m_globalArrays;
+    std::vector<std::list<Scope>> m_frames;
+    int m_remainingSteps = 0;
+};
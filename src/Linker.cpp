@@ -0,0 +1,125 @@
+#include "Linker.hpp"
+#include <filesystem>
+#include <list>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+#ifdef COMPILER_USE_LLD
+#include <lld/Common/CommonLinkerContext.h>
+#include <lld/Common/Driver.h>
+#include <mutex>
+#else
+#include <llvm/Support/Program.h>
+#endif
+
+namespace{
+
+// Owns a memory backed file, its /proc path can be handed to the linker like a regular file.
+class MemoryFile{
+
+public:
+    MemoryFile(const char* name)
+        : m_fd(memfd_create(name, 0)){
+    }
+
+    ~MemoryFile(){
+        if(m_fd != -1){
+            close(m_fd);
+        }
+    }
+
+    bool write(const std::vector<char>& data){
+        size_t written = 0;
+        while(m_fd != -1 && written < data.size()){
+            ssize_t result = ::write(m_fd, data.data() + written, data.size() - written);
+            if(result <= 0){
+                return false;
+            }
+            written += result;
+        }
+        return m_fd != -1;
+    }
+
+    std::string path() const{
+        return "/proc/self/fd/" + std::to_string(m_fd);
+    }
+
+private:
+    int m_fd;
+};
+
+}
+
+Linker::Linker(const std::filesystem::path& stdLibPath)
+    : m_stdLibPath(stdLibPath){
+
+}
+
+bool Linker::link(const std::vector<std::vector<char>>& objects, const std::string& outputFile, std::string& errorMsg){
+    if(!std::filesystem::exists(m_stdLibPath)){
+        errorMsg = "Could not find standard library : " + m_stdLibPath.string();
+        return false;
+    }
+    std::list<MemoryFile> objectFiles;
+    std::vector<std::string> args = {"ld.lld"};
+    for(const std::vector<char>& object: objects){
+        MemoryFile& objectFile = objectFiles.emplace_back("object");
+        if(!objectFile.write(object)){
+            errorMsg = "Could not create in memory object file";
+            return false;
+        }
+        args.push_back(objectFile.path());
+    }
+    for(const std::string& symbol: m_requiredSymbols){
+        args.push_back("--undefined=" + symbol);
+    }
+    args.insert(args.end(), {m_stdLibPath.string(), "-o", outputFile});
+    return runLinker(args, errorMsg);
+}
+
+void Linker::requireSymbol(const std::string& symbol){
+    m_requiredSymbols.push_back(symbol);
+}
+
+#ifdef COMPILER_USE_LLD
+
+bool Linker::runLinker(const std::vector<std::string>& args, std::string& errorMsg){
+    std::vector<const char*> argv;
+    for(const std::string& arg: args){
+        argv.push_back(arg.c_str());
+    }
+    std::string output;
+    llvm::raw_string_ostream outputStream(output);
+    llvm::raw_string_ostream errorStream(errorMsg);
+    // lld keeps its state in globals, only one link can run at a time within the process
+    static std::mutex lldMutex;
+    std::lock_guard<std::mutex> lock(lldMutex);
+    bool isLinked = lld::elf::link(argv, outputStream, errorStream, false, false);
+    // the context link() leaves behind has to go before the next link can create its own
+    lld::CommonLinkerContext::destroy();
+    errorStream.flush();
+    return isLinked;
+}
+
+#else
+
+bool Linker::runLinker(const std::vector<std::string>& args, std::string& errorMsg){
+    auto linkerPath = llvm::sys::findProgramByName(args[0]);
+    if(!linkerPath){
+        errorMsg = "Could not find " + args[0];
+        return false;
+    }
+    std::vector<llvm::StringRef> argv(args.begin(), args.end());
+    int result = llvm::sys::ExecuteAndWait(*linkerPath, argv, llvm::None, {}, 0, 0, &errorMsg);
+    if(result != 0 && errorMsg.empty()){
+        errorMsg = args[0] + " exited with code " + std::to_string(result);
+    }
+    return result == 0;
+}
+
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/*
+    Links in memory object files with the standard library archive into an executable.
+    When compiled with COMPILER_USE_LLD the lld library is used in-process, otherwise
+    ld.lld is executed directly (without a shell).
+*/
+class Linker{
+
+public:
+    Linker(const std::filesystem::path& stdLibPath);
+    bool link(const std::vector<std::vector<char>>& objects, const std::string& outputFile, std::string& errorMsg);
+    // symbol that must be linked in from the standard library even if nothing references it
+    void requireSymbol(const std::string& symbol);
+
+private:
+    bool runLinker(const std::vector<std::string>& args, std::string& errorMsg);
+
+    const std::filesystem::path m_stdLibPath;
+    std::vector<std::string> m_requiredSymbols;
+};
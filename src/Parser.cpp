@@ -2,8 +2,11 @@
 #include "AST.hpp"
 #include "ErrorHandler.hpp"
 #include "Token.hpp"
+#include <cstdint>
 #include <iostream>
 #include <list>
+#include <string>
+#include <string_view>
 #include <sys/types.h>
 
 using namespace ast;
@@ -13,7 +16,8 @@ namespace{
 bool isDataType(Token& token){
     return token.m_tokenType.keywordType == Keyword::INT ||
                 token.m_tokenType.keywordType == Keyword::CHAR ||
-                token.m_tokenType.keywordType == Keyword::FLOAT;
+                token.m_tokenType.keywordType == Keyword::FLOAT ||
+                getLaneCount(token.m_tokenType.keywordType) != 0;
 }
 
 bool isType(Token& token, Type type){
@@ -33,6 +37,15 @@ bool isSymbol(Token& token, char symbol){
     return token.m_tokenType.symbol == symbol;
 }
 
+// array indexes nest like parentheses eg: a[(i + 1) * 2]
+bool isOpeningBracket(Token& token){
+    return isSymbol(token, '(') || isSymbol(token, '[');
+}
+
+bool isClosingBracket(Token& token){
+    return isSymbol(token, ')') || isSymbol(token, ']');
+}
+
 }
 
 Parser::Parser(Tokenizer& tokenizer, const ErrorHandler& errorHandler): m_tokenizer(tokenizer), m_errorHandler(errorHandler){
@@ -43,9 +56,9 @@ TokenBuffer Parser::prefetchToken(char end){
     int bracketLevel = 0;
     Token temp = m_tokenizer.nextToken();
     while(!isSymbol(temp, end) || bracketLevel > 0){
-        if(isSymbol(temp, '(')){
+        if(isOpeningBracket(temp)){
             bracketLevel++;
-        }else if(isSymbol(temp, ')')){
+        }else if(isClosingBracket(temp)){
             bracketLevel--;
         }
         
@@ -93,6 +106,14 @@ File Parser::evaluate(){
         }else if(isKeyword(currentToken, Keyword::FUNC)){
             Function* function = evaluateFunctionDefinition();
             file.functions.push_back(function);
+        }else if(isDataType(currentToken)){
+            file.globals.push_back(evaluateDeclarativeStatement(currentToken, false));
+        }else if(isKeyword(currentToken, Keyword::CONST)){
+            Token dataType = m_tokenizer.nextToken();
+            if(!isDataType(dataType)){
+                m_errorHandler.reportError(error::INVALID_EXPR, dataType);
+            }
+            file.globals.push_back(evaluateDeclarativeStatement(dataType, true));
         }else{
             m_errorHandler.reportError(error::INVALID_EXPR, currentToken);
         }
@@ -103,6 +124,11 @@ File Parser::evaluate(){
 
 Function* Parser::evaluateFunctionDefinition(){
     Token expectedReturnType = m_tokenizer.nextToken();
+    // memo is a qualifier only in front of the return type, elsewhere it is a plain identifier
+    const bool isMemo = expectedReturnType.m_tokenType.type == Type::IDENTIFIER && std::string_view(expectedReturnType.m_value, expectedReturnType.m_valueSize) == "memo";
+    if(isMemo){
+        expectedReturnType = m_tokenizer.nextToken();
+    }
     if(!isKeyword(expectedReturnType, Keyword::VOID) && !isDataType(expectedReturnType)){
         m_errorHandler.reportError("Expectec valid return type ", expectedReturnType);
     }
@@ -112,6 +138,7 @@ Function* Parser::evaluateFunctionDefinition(){
     Token* returnTypeCopy = createTokenCopy(expectedReturnType);
     Token* identifierCopy = createTokenCopy(identifier);
     Function* function = new Function(returnTypeCopy, identifierCopy);
+    function->m_isMemo = isMemo;
 
     extractParams(function->m_parameters);
     verifyNextToken('{');
@@ -159,15 +186,15 @@ ConditionalStatement* Parser::evaluateIfConditionalStatement(){
     return conditionalStatement;
 }
 
-ReturnStatement* Parser::evaluateReturnStatement(){
+ReturnStatement* Parser::evaluateReturnStatement(Token& keyword){
     Token semi_colon = m_tokenizer.peekToken();
     if(isSymbol(semi_colon, STATEMENT_TERMINATOR)){
         m_tokenizer.nextToken();
-        return new ReturnStatement();
+        return new ReturnStatement(createTokenCopy(keyword));
     }
     TokenBuffer tokenBuffer = prefetchToken(';');
     Expression* expr = evaluateExpression(tokenBuffer.tokens, 0, tokenBuffer.size-1);
-    ReturnStatement* returnStatement = new ReturnStatement(expr);
+    ReturnStatement* returnStatement = new ReturnStatement(createTokenCopy(keyword), expr);
     return returnStatement;
 }
 
@@ -176,7 +203,7 @@ WhileLoop* Parser::evaluateWhileLoop(){
     TokenBuffer exprTokens = prefetchToken(')');
     Expression* expr = evaluateExpression(exprTokens.tokens, 0, exprTokens.size-1);
     WhileLoop* whileLoop = new WhileLoop(expr);
-    verifyNextToken('{');
+    evaluateLoopHints(whileLoop->m_hints);
 
     Statement* stmnt = evaluateStatement();
     while(stmnt != nullptr){
@@ -186,6 +213,40 @@ WhileLoop* Parser::evaluateWhileLoop(){
     return whileLoop;
 }
 
+void Parser::evaluateLoopHints(LoopHints& loopHints){
+    Token hintToken = m_tokenizer.nextToken();
+    while(!isSymbol(hintToken, '{')){
+        if(!isType(hintToken, Type::IDENTIFIER)){
+            m_errorHandler.reportError("Expected {", hintToken);
+        }
+        uint32_t count = 0;
+        Token nextToken = m_tokenizer.peekToken();
+        if(isSymbol(nextToken, '(')){
+            m_tokenizer.nextToken();
+            Token countToken = verifyNextToken(Type::NUMERIC_LITERAL);
+            if(countToken.m_tokenType.isFloatingPointValue){
+                m_errorHandler.reportError(error::INVALID_NUMERIC_LITERAL, countToken);
+            }
+            count = std::stoul(std::string(countToken.m_value, countToken.m_valueSize));
+            verifyNextToken(')');
+        }
+        const std::string_view hint(hintToken.m_value, hintToken.m_valueSize);
+        if(hint == "unroll"){
+            loopHints.m_unroll = true;
+            loopHints.m_unrollCount = count;
+        }else if(hint == "vectorize"){
+            loopHints.m_vectorize = true;
+            loopHints.m_vectorizeWidth = count;
+        }else if(hint == "parallel"){
+            loopHints.m_parallel = true;
+            loopHints.m_parallelGrain = count;
+        }else{
+            m_errorHandler.reportError("Unknown loop hint", hintToken);
+        }
+        hintToken = m_tokenizer.nextToken();
+    }
+}
+
 Statement* Parser::evaluateStatement(){
     Token startToken = m_tokenizer.nextToken();
     if(isSymbol(startToken, '}')) return nullptr;
@@ -197,12 +258,16 @@ Statement* Parser::evaluateStatement(){
         Token dataType = m_tokenizer.nextToken();
         if(isDataType(dataType)){
             DeclarativeStatement* declarativeStatement = evaluateDeclarativeStatement(dataType, true);
+            return new Statement(declarativeStatement);
         }
     }else if(isType(startToken, Type::IDENTIFIER)){
         Token nextToken = m_tokenizer.nextToken();
         if(isSymbol(nextToken, '=')){
             AssignmentStatement* assignmentStatement = evaluateAssignmentStatement(startToken);
             return new Statement(assignmentStatement);
+        }else if(isSymbol(nextToken, '[')){
+            AssignmentStatement* assignmentStatement = evaluateArrayAssignmentStatement(startToken);
+            return new Statement(assignmentStatement);
         }else if(isSymbol(nextToken, '(')){
             FunctionCallStatement* functionCallStatement = evaluateFunctionCallStatement(startToken);
             return new Statement(functionCallStatement);
@@ -211,7 +276,7 @@ Statement* Parser::evaluateStatement(){
         ConditionalStatement* conditionalStatement = evaluateIfConditionalStatement();
         return new Statement(conditionalStatement);
     }else if(isKeyword(startToken, Keyword::RETURN)){
-        ReturnStatement* returnStatement = evaluateReturnStatement();
+        ReturnStatement* returnStatement = evaluateReturnStatement(startToken);
         return new Statement(returnStatement);
     }else if(isKeyword(startToken, Keyword::WHILE)){
         WhileLoop* whileLoop = evaluateWhileLoop();
@@ -234,7 +299,12 @@ bool Parser::extractParams(std::list<Parameter>& params){
         }
         Token* identifierCopy = createTokenCopy(identifier);
         Token endToken = m_tokenizer.nextToken();
-        params.push_back(Parameter{dataTypeCopy, identifierCopy});
+        uint32_t arraySize = 0;
+        if(isSymbol(endToken, '[')){
+            arraySize = evaluateArraySize();
+            endToken = m_tokenizer.nextToken();
+        }
+        params.push_back(Parameter{dataTypeCopy, identifierCopy, arraySize});
         if(isSymbol(endToken, ',')){
             extractParams(params);
         }else if(!isSymbol(endToken, ')')){
@@ -260,9 +330,9 @@ FunctionCallStatement* Parser::evaluateFunctionCallStatement(Token& functionName
 void Parser::extractArgsInFunctionCall(std::list<Expression*>& args, Token* tokens, int start, int end){
     int bracketLevel = 0;
     for(int i=start; i<= end; i++){
-        if(isSymbol(tokens[i], '(')){
+        if(isOpeningBracket(tokens[i])){
             bracketLevel++;
-        }else if(isSymbol(tokens[i], ')')){
+        }else if(isClosingBracket(tokens[i])){
             bracketLevel--;
         }
         if(bracketLevel != 0) continue;
@@ -285,10 +355,48 @@ AssignmentStatement* Parser::evaluateAssignmentStatement(Token& identifier){
     return new AssignmentStatement(identifierCopy, expression);
 }
 
+AssignmentStatement* Parser::evaluateArrayAssignmentStatement(Token& identifier){
+    TokenBuffer indexBuffer = prefetchToken(']');
+    Expression* index = evaluateExpression(indexBuffer.tokens, 0, indexBuffer.size-1);
+    verifyNextToken('=');
+    TokenBuffer tokenBuffer = prefetchToken(';');
+    Expression* expression = evaluateExpression(tokenBuffer.tokens, 0, tokenBuffer.size-1);
+    Token* identifierCopy = new Token(std::move(identifier));
+    return new AssignmentStatement(identifierCopy, index, expression);
+}
+
+// reads the size and closing bracket of an array declaration eg: int a[16]
+uint32_t Parser::evaluateArraySize(){
+    Token sizeToken = m_tokenizer.nextToken();
+    if(!isType(sizeToken, Type::NUMERIC_LITERAL) || sizeToken.m_tokenType.isFloatingPointValue){
+        m_errorHandler.reportError(error::INVALID_ARRAY_SIZE, sizeToken);
+    }
+    const unsigned long size = std::stoul(std::string(sizeToken.m_value, sizeToken.m_valueSize));
+    if(size == 0 || size > UINT32_MAX){
+        m_errorHandler.reportError(error::INVALID_ARRAY_SIZE, sizeToken);
+    }
+    verifyNextToken(']');
+    return static_cast<uint32_t>(size);
+}
+
 DeclarativeStatement* Parser::evaluateDeclarativeStatement(Token& dataType, bool isConst){
     Token identifier = verifyNextToken(Type::IDENTIFIER);
     
     Token nextToken = m_tokenizer.nextToken();
+    if(isSymbol(nextToken, '[')){
+        const uint32_t arraySize = evaluateArraySize();
+        DeclarativeStatement* declarativeStatement = new DeclarativeStatement(
+            createTokenCopy(dataType), createTokenCopy(identifier), isConst);
+        declarativeStatement->m_arraySize = arraySize;
+        Token terminator = m_tokenizer.nextToken();
+        if(isSymbol(terminator, '=')){
+            evaluateArrayInitializer(declarativeStatement->m_elements);
+            declarativeStatement->m_isInitialized = true;
+        }else if(!isSymbol(terminator, STATEMENT_TERMINATOR)){
+            m_errorHandler.reportError(error::ARRAY_INITIALIZED, identifier);
+        }
+        return declarativeStatement;
+    }
     if(isSymbol(nextToken, STATEMENT_TERMINATOR)){
         return new DeclarativeStatement(
             createTokenCopy(dataType), createTokenCopy(identifier), isConst);
@@ -303,6 +411,43 @@ DeclarativeStatement* Parser::evaluateDeclarativeStatement(Token& dataType, bool
     }
 }
 
+// elements are read one at a time so that the size of a table is not limited by the token buffer
+void Parser::evaluateArrayInitializer(std::list<Expression*>& elements){
+    verifyNextToken('{');
+    TokenBuffer tokenBuffer;
+    int bracketLevel = 0;
+    Token token = m_tokenizer.nextToken();
+    while(bracketLevel > 0 || !isSymbol(token, '}')){
+        if(isType(token, Type::NIL)){
+            m_errorHandler.reportError("Expected }", token);
+        }
+        if(bracketLevel == 0 && isSymbol(token, ',')){
+            if(tokenBuffer.size == 0){
+                m_errorHandler.reportError(error::INVALID_EXPR, token);
+            }
+            elements.push_back(evaluateExpression(tokenBuffer.tokens, 0, tokenBuffer.size-1));
+            tokenBuffer.size = 0;
+        }else{
+            if(isOpeningBracket(token)){
+                bracketLevel++;
+            }else if(isClosingBracket(token)){
+                bracketLevel--;
+            }
+            if(tokenBuffer.size == ::MAX_TOKEN_BUFFER_SIZE){
+                m_errorHandler.reportError(error::EXPR_HUGE, token);
+            }
+            tokenBuffer.tokens[tokenBuffer.size++] = std::move(token);
+        }
+        token = m_tokenizer.nextToken();
+    }
+    if(tokenBuffer.size != 0){
+        elements.push_back(evaluateExpression(tokenBuffer.tokens, 0, tokenBuffer.size-1));
+    }else if(!elements.empty()){
+        m_errorHandler.reportError(error::INVALID_EXPR, token);
+    }
+    verifyNextToken(STATEMENT_TERMINATOR);
+}
+
 Factor* Parser::evaluateFactor(Token* tokens, int start, int end){
     Token& firstToken = tokens[start];
 
@@ -323,6 +468,9 @@ Factor* Parser::evaluateFactor(Token* tokens, int start, int end){
             FunctionCallStatement* functionCall = new FunctionCallStatement(identifierCopy, args);
             
             return new Factor(functionCall);
+        }else if(isSymbol(tokens[start+1], '[') && isSymbol(tokens[end], ']')){
+            Expression* index = evaluateExpression(tokens, start+2, end-1);
+            return new Factor(new ArrayAccess(createTokenCopy(firstToken), index));
         }else{
             m_errorHandler.reportError("Invalid expression", tokens[start+1]);
         }
@@ -353,9 +501,9 @@ Term* Parser::evaluateTerm(Token* tokens, int start, int end){
 
     for(int i=start; i<=end; i++){
         Token& currentToken = tokens[i];
-        if(isSymbol(currentToken,'(')){
+        if(isOpeningBracket(currentToken)){
             bracketLevel++;
-        }else if(isSymbol(currentToken,')')){
+        }else if(isClosingBracket(currentToken)){
             bracketLevel--;
         }
         if(bracketLevel != 0) continue;
@@ -389,9 +537,9 @@ Additive* Parser::evaluateAdditive(Token* tokens, int start, int end){
 
     for(int i=start; i<=end; i++){
         Token& currentToken = tokens[i];
-        if(isSymbol(currentToken,'(')){
+        if(isOpeningBracket(currentToken)){
             bracketLevel++;
-        }else if(isSymbol(currentToken,')')){
+        }else if(isClosingBracket(currentToken)){
             bracketLevel--;
         }
         if(bracketLevel != 0) continue;
@@ -429,9 +577,9 @@ Relational* Parser::evaluateRelational(Token* tokens, int start, int end){
     for(int i=start; i<=end; i++){
         Token& currentToken = tokens[i];
 
-        if(isSymbol(currentToken,'(')){
+        if(isOpeningBracket(currentToken)){
             bracketLevel++;
-        }else if(isSymbol(currentToken,')')){
+        }else if(isClosingBracket(currentToken)){
             bracketLevel--;
         }
         if(bracketLevel != 0) continue;
@@ -480,9 +628,9 @@ Expression* Parser::evaluateExpression(Token* tokens, int start, int end){
     for(int i=start; i<=end; i++){
         Token& currentToken = tokens[i];
 
-        if(isSymbol(currentToken,'(')){
+        if(isOpeningBracket(currentToken)){
             bracketLevel++;
-        }else if(isSymbol(currentToken,')')){
+        }else if(isClosingBracket(currentToken)){
             bracketLevel--;
         }
         if(bracketLevel != 0) continue;
@@ -490,9 +638,8 @@ Expression* Parser::evaluateExpression(Token* tokens, int start, int end){
         Token& nextToken = tokens[i+1];
 
         if(isSymbol(currentToken, '&') && isSymbol(nextToken, '&')){
-            
             update(i, Opcode::LOGICAL_AND);
-        }else if(isSymbol(currentToken, '&') && isSymbol(nextToken, '&')){
+        }else if(isSymbol(currentToken, '|') && isSymbol(nextToken, '|')){
             update(i, Opcode::LOGICAL_OR);
         }
     }
@@ -23,11 +23,15 @@ private:
     ast::Statement* evaluateStatement();
     TokenBuffer prefetchToken(char end);
     ast::DeclarativeStatement* evaluateDeclarativeStatement(Token& keyword, bool isConst);
+    uint32_t evaluateArraySize();
+    void evaluateArrayInitializer(std::list<ast::Expression*>& elements);
     ast::ConditionalStatement* evaluateIfConditionalStatement();
     ast::WhileLoop* evaluateWhileLoop();
-    ast::ReturnStatement* evaluateReturnStatement();
+    void evaluateLoopHints(ast::LoopHints& loopHints);
+    ast::ReturnStatement* evaluateReturnStatement(Token& keyword);
     bool extractParams(std::list<ast::Parameter>& params);
     ast::AssignmentStatement* evaluateAssignmentStatement(Token& identifier);
+    ast::AssignmentStatement* evaluateArrayAssignmentStatement(Token& identifier);
     ast::FunctionCallStatement* evaluateFunctionCallStatement(Token& functionName);
     ast::Expression* evaluateExpression(Token* tokens, int start, int end);
     ast::Additive* evaluateAdditive(Token* tokens, int start, int end);
@@ -0,0 +1,236 @@
+#include "../parallel.h"
+#include "../syscall.h"
+#include "../util.h"
+
+/*
+    Runtime of parallel loops. Worker threads are started with clone on the first loop and
+    sleep on a futex in between. Each thread (the caller included) is given an even share of
+    the iteration space, takes blocks from the front of its own range and once it is empty
+    steals the back half of another thread's range, so uneven iterations do not leave cores idle.
+    Loops started while another one is running, from inside a parallel loop or from another program
+    jit compiled into the same process, run on the calling thread.
+*/
+
+#define MAX_THREADS 64
+#define STACK_SIZE (8L << 20)
+#define BLOCKS_PER_THREAD 8
+
+#define PROT_READ 1
+#define PROT_WRITE 2
+#define MAP_PRIVATE 0x02
+#define MAP_ANONYMOUS 0x20
+#define MAP_STACK 0x20000
+
+#define CLONE_THREAD_FLAGS (0x100 | 0x200 | 0x400 | 0x800 | 0x10000 | 0x40000) // VM FS FILES SIGHAND THREAD SYSVSEM
+
+#define FUTEX_WAIT_PRIVATE 128
+#define FUTEX_WAKE_PRIVATE 129
+
+#define OPEN_READ_ONLY 0
+#define ENVIRONMENT_SIZE 16384
+
+// offsets from the start of the loop, end in the high half so that both move with a single compare exchange
+struct Range{
+    unsigned long long bounds;
+} __attribute__((aligned(64)));
+
+// everything below is owned by the thread that set isRunning
+static int isRunning;
+static struct Range ranges[MAX_THREADS];
+static int threadCount;
+
+static LoopBody loopBody;
+static void* loopContext;
+static int loopBegin;
+static unsigned int blockSize;
+static unsigned int iterationCount;
+static unsigned int completedIterations __attribute__((aligned(64)));
+static int busyWorkers __attribute__((aligned(64)));
+static int generation __attribute__((aligned(64)));
+
+static unsigned long long pack(unsigned int begin, unsigned int end){
+    return (unsigned long long)end << 32 | begin;
+}
+
+static int takeBlock(struct Range* range, unsigned int* begin, unsigned int* end){
+    unsigned long long bounds = __atomic_load_n(&range->bounds, __ATOMIC_ACQUIRE);
+    while(1){
+        unsigned int first = (unsigned int)bounds;
+        unsigned int last = (unsigned int)(bounds >> 32);
+        if(first >= last){
+            return 0;
+        }
+        unsigned int next = last - first > blockSize ? first + blockSize : last;
+        if(__atomic_compare_exchange_n(&range->bounds, &bounds, pack(next, last), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)){
+            *begin = first;
+            *end = next;
+            return 1;
+        }
+    }
+}
+
+// only called with an empty own range, so no other thread steals from it meanwhile
+static int steal(int self){
+    for(int i=1;i<threadCount;i++){
+        struct Range* victim = &ranges[(self + i) % threadCount];
+        unsigned long long bounds = __atomic_load_n(&victim->bounds, __ATOMIC_ACQUIRE);
+        unsigned int first = (unsigned int)bounds;
+        unsigned int last = (unsigned int)(bounds >> 32);
+        if(first >= last || last - first <= blockSize){
+            continue;
+        }
+        unsigned int middle = first + (last - first) / 2;
+        if(__atomic_compare_exchange_n(&victim->bounds, &bounds, pack(first, middle), 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)){
+            __atomic_store_n(&ranges[self].bounds, pack(middle, last), __ATOMIC_RELEASE);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void runLoop(int self){
+    unsigned int begin, end;
+    while(__atomic_load_n(&completedIterations, __ATOMIC_ACQUIRE) < iterationCount){
+        if(takeBlock(&ranges[self], &begin, &end)){
+            loopBody(loopContext, (int)((unsigned int)loopBegin + begin), (int)((unsigned int)loopBegin + end));
+            __atomic_add_fetch(&completedIterations, end - begin, __ATOMIC_RELEASE);
+        }else if(!steal(self)){
+            __builtin_ia32_pause();
+        }
+    }
+}
+
+static void workerMain(long self){
+    int seenGeneration = 0;
+    while(1){
+        while(__atomic_load_n(&generation, __ATOMIC_ACQUIRE) == seenGeneration){
+            sys_futex(&generation, FUTEX_WAIT_PRIVATE, seenGeneration);
+        }
+        seenGeneration = __atomic_load_n(&generation, __ATOMIC_ACQUIRE);
+        runLoop((int)self);
+        __atomic_sub_fetch(&busyWorkers, 1, __ATOMIC_RELEASE);
+    }
+}
+
+// PARALLEL_THREADS=N overrides the number of threads, read from /proc since there is no libc to keep the environment
+static int readThreadCountOverride(){
+    static char environment[ENVIRONMENT_SIZE];
+    static const char name[] = "PARALLEL_THREADS=";
+    int fileDescriptor = sys_open("/proc/self/environ", OPEN_READ_ONLY, 0);
+    if(fileDescriptor < 0){
+        return 0;
+    }
+    sys_read(fileDescriptor, environment, ENVIRONMENT_SIZE - 1);
+    sys_close(fileDescriptor);
+    int count = 0;
+    for(int i=0;i<ENVIRONMENT_SIZE - (int)sizeof(name);i++){
+        if(i != 0 && environment[i - 1] != '\0'){
+            continue;
+        }
+        int length = 0;
+        while(name[length] != '\0' && environment[i + length] == name[length]){
+            length++;
+        }
+        if(name[length] == '\0'){
+            convertAsciiToInt(environment + i + length, ENVIRONMENT_SIZE - i - length, &count);
+            break;
+        }
+    }
+    return count;
+}
+
+static int countCores(){
+    unsigned char mask[128];
+    int size = sys_sched_getaffinity(0, sizeof(mask), mask);
+    int count = 0;
+    for(int i=0;i<size;i++){
+        for(unsigned char bits = mask[i]; bits != 0; bits &= bits - 1){
+            count++;
+        }
+    }
+    return count;
+}
+
+#ifdef STDLIB_HOST
+#include <pthread.h>
+
+// inside the compiler the c library owns the process, its threads need their own tls so they are started through it
+static void* hostWorkerMain(void* self){
+    workerMain((long)self);
+    return 0;
+}
+
+static int startThread(long self){
+    pthread_t thread;
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    int result = pthread_create(&thread, &attributes, hostWorkerMain, (void*)self);
+    pthread_attr_destroy(&attributes);
+    return result == 0;
+}
+#else
+static int startThread(long self){
+    char* stack = sys_mmap(0, STACK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    // errors are returned as -errno
+    if((unsigned long)stack > -4096UL){
+        return 0;
+    }
+    return sys_clone_thread(CLONE_THREAD_FLAGS, stack + STACK_SIZE, workerMain, self) > 0;
+}
+#endif
+
+// loops are spread over the threads that could be started
+static void startWorkers(){
+    int count = readThreadCountOverride();
+    if(count <= 0){
+        count = countCores();
+    }
+    count = count < 1 ? 1 : (count > MAX_THREADS ? MAX_THREADS : count);
+    threadCount = 1;
+    while(threadCount < count && startThread(threadCount)){
+        threadCount++;
+    }
+}
+
+void parallelFor(LoopBody body, void* context, int begin, int end, int grain){
+    if(end <= begin){
+        return;
+    }
+    if(__atomic_exchange_n(&isRunning, 1, __ATOMIC_ACQUIRE)){
+        body(context, begin, end);
+        return;
+    }
+    if(threadCount == 0){
+        startWorkers();
+    }
+    if(threadCount == 1){
+        body(context, begin, end);
+        __atomic_store_n(&isRunning, 0, __ATOMIC_RELEASE);
+        return;
+    }
+    loopBody = body;
+    loopContext = context;
+    loopBegin = begin;
+    iterationCount = (unsigned int)end - (unsigned int)begin;
+    blockSize = grain > 0 ? (unsigned int)grain : iterationCount / (threadCount * BLOCKS_PER_THREAD);
+    if(blockSize == 0){
+        blockSize = 1;
+    }
+    completedIterations = 0;
+    unsigned int share = iterationCount / threadCount;
+    for(int i=0;i<threadCount;i++){
+        unsigned int last = (i == threadCount - 1) ? iterationCount : share * (i + 1);
+        ranges[i].bounds = pack(share * i, last);
+    }
+    busyWorkers = threadCount - 1;
+    __atomic_add_fetch(&generation, 1, __ATOMIC_RELEASE);
+    sys_futex(&generation, FUTEX_WAKE_PRIVATE, MAX_THREADS);
+
+    runLoop(0);
+    // workers still looking for blocks would see the ranges of the next loop
+    while(__atomic_load_n(&busyWorkers, __ATOMIC_ACQUIRE) != 0){
+        __builtin_ia32_pause();
+    }
+    __atomic_store_n(&isRunning, 0, __ATOMIC_RELEASE);
+}
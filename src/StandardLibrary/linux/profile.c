@@ -0,0 +1,86 @@
+#include "../syscall.h"
+
+/*
+    Minimal profile runtime for programs built with --profile-generate.
+    When main returns the counters emitted by llvm instrumentation are written in the
+    llvm raw profile format (version 8), which --profile-use and llvm-profdata can read.
+*/
+
+#define PROFILE_RAW_MAGIC ((unsigned long long)255 << 56 | (unsigned long long)'l' << 48 | \
+        (unsigned long long)'p' << 40 | (unsigned long long)'r' << 32 | (unsigned long long)'o' << 24 | \
+        (unsigned long long)'f' << 16 | (unsigned long long)'r' << 8 | (unsigned long long)129)
+#define PROFILE_RAW_VERSION 8
+#define PROFILE_DATA_RECORD_SIZE 48
+#define PROFILE_VALUE_KIND_LAST 1
+
+#define OPEN_WRITE_ONLY 01
+#define OPEN_CREATE 0100
+#define OPEN_TRUNCATE 01000
+
+// section bounds are provided by the linker
+extern char __start___llvm_prf_data[] __attribute__((weak));
+extern char __stop___llvm_prf_data[] __attribute__((weak));
+extern char __start___llvm_prf_cnts[] __attribute__((weak));
+extern char __stop___llvm_prf_cnts[] __attribute__((weak));
+extern char __start___llvm_prf_names[] __attribute__((weak));
+extern char __stop___llvm_prf_names[] __attribute__((weak));
+
+// emitted by the instrumentation into the program
+extern const unsigned long long __llvm_profile_raw_version __attribute__((weak));
+extern const char __llvm_profile_filename[] __attribute__((weak));
+
+// the compiler links with -u __llvm_profile_runtime so that this file is taken out of the archive
+int __llvm_profile_runtime;
+
+static void writeAll(int fileDescriptor, char* data, unsigned long size){
+    while(size > 0){
+        int chunk = size > 0x40000000 ? 0x40000000 : (int)size;
+        sys_write(fileDescriptor, data, chunk);
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+void writeProfile(){
+    if(__start___llvm_prf_data == 0 || &__llvm_profile_raw_version == 0){
+        return;
+    }
+    // the low byte is the format version, the sections of any other version are laid out differently
+    if((__llvm_profile_raw_version & 0xff) != PROFILE_RAW_VERSION){
+        return;
+    }
+    const char* filename = "default.profraw";
+    if(__llvm_profile_filename != 0 && __llvm_profile_filename[0] != '\0'){
+        filename = __llvm_profile_filename;
+    }
+    unsigned long dataSize = __stop___llvm_prf_data - __start___llvm_prf_data;
+    unsigned long countersSize = __stop___llvm_prf_cnts - __start___llvm_prf_cnts;
+    unsigned long namesSize = __stop___llvm_prf_names - __start___llvm_prf_names;
+    unsigned long namesPadding = (8 - namesSize % 8) % 8;
+
+    unsigned long long header[] = {
+        PROFILE_RAW_MAGIC,
+        __llvm_profile_raw_version,
+        0, // binary ids size
+        dataSize / PROFILE_DATA_RECORD_SIZE,
+        0, // padding before counters
+        countersSize / sizeof(unsigned long long),
+        0, // padding after counters
+        namesSize,
+        (unsigned long long)(__start___llvm_prf_cnts - __start___llvm_prf_data),
+        (unsigned long long)__start___llvm_prf_names,
+        PROFILE_VALUE_KIND_LAST
+    };
+    char padding[8] = {0};
+
+    int fileDescriptor = sys_open(filename, OPEN_WRITE_ONLY | OPEN_CREATE | OPEN_TRUNCATE, 0644);
+    if(fileDescriptor < 0){
+        return;
+    }
+    writeAll(fileDescriptor, (char*)header, sizeof(header));
+    writeAll(fileDescriptor, __start___llvm_prf_data, dataSize);
+    writeAll(fileDescriptor, __start___llvm_prf_cnts, countersSize);
+    writeAll(fileDescriptor, __start___llvm_prf_names, namesSize);
+    writeAll(fileDescriptor, padding, namesPadding);
+    sys_close(fileDescriptor);
+}
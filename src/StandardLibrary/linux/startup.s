@@ -2,11 +2,24 @@
 
 .section .text
 
+# only linked in for programs built with --profile-generate
+.weak writeProfile
+
 .global _start
 _start:
-    push rbp
-    mov rbp, rsp
+    # rsp is 16 byte aligned here, the call leaves it as functions expect it. rbp = 0 ends stack walks
+    xor rbp, rbp
     call main
     mov rdi, rax
-    mov rax, 60
+    lea rcx, [rip + writeProfile]
+    test rcx, rcx
+    jz .Lexit
+    mov rbx, rdi
+    call rcx
+    mov rdi, rbx
+.Lexit:
+    # exit_group, parallel loop workers are still waiting for work
+    mov rax, 231
     syscall
+
+.section .note.GNU-stack,"",@progbits
@@ -19,4 +19,75 @@ sys_read:
     syscall
     pop rbp
     ret
-    
\ No newline at end of file
+
+.global sys_open
+sys_open:
+    push rbp
+    mov rbp, rsp
+    mov rax, 2
+    syscall
+    pop rbp
+    ret
+
+.global sys_close
+sys_close:
+    push rbp
+    mov rbp, rsp
+    mov rax, 3
+    syscall
+    pop rbp
+    ret
+    
+.global sys_mmap
+sys_mmap:
+    push rbp
+    mov rbp, rsp
+    mov r10, rcx
+    mov rax, 9
+    syscall
+    pop rbp
+    ret
+
+.global sys_sched_getaffinity
+sys_sched_getaffinity:
+    push rbp
+    mov rbp, rsp
+    mov rax, 204
+    syscall
+    pop rbp
+    ret
+
+.global sys_futex
+sys_futex:
+    push rbp
+    mov rbp, rsp
+    xor r10, r10
+    mov rax, 202
+    syscall
+    pop rbp
+    ret
+
+# function and argument are left on the new stack, only the child finds them there
+.global sys_clone_thread
+sys_clone_thread:
+    sub rsi, 16
+    mov [rsi], rdx
+    mov [rsi + 8], rcx
+    xor rdx, rdx
+    xor r10, r10
+    xor r8, r8
+    mov rax, 56
+    syscall
+    test rax, rax
+    jnz .Lparent
+    pop rax
+    pop rdi
+    xor rbp, rbp
+    call rax
+    xor rdi, rdi
+    mov rax, 60
+    syscall
+.Lparent:
+    ret
+
+.section .note.GNU-stack,"",@progbits
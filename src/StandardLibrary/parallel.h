@@ -0,0 +1,9 @@
+#pragma once
+
+typedef void (*LoopBody)(void* context, int begin, int end);
+
+/*
+    Runs body over [begin, end) split into blocks spread across all cores, returns once every block has run.
+    grain is the number of iterations per block, 0 picks one from the iteration count.
+*/
+void parallelFor(LoopBody body, void* context, int begin, int end, int grain);
@@ -1,4 +1,67 @@
 #pragma once
 
+#ifdef STDLIB_INLINE_SYSCALLS
+
+// used when the stdlib is built as bitcode, the syscall can then be inlined into its callers
+static inline void sys_write(int fileDescriptor, char* bufferAddress, int size){
+    long result;
+    __asm__ volatile("syscall" : "=a"(result) : "a"(1L), "D"((long)fileDescriptor), "S"(bufferAddress), "d"((long)size) : "rcx", "r11", "memory");
+}
+
+static inline void sys_read(int fileDescriptor, char* bufferAddress, int size){
+    long result;
+    __asm__ volatile("syscall" : "=a"(result) : "a"(0L), "D"((long)fileDescriptor), "S"(bufferAddress), "d"((long)size) : "rcx", "r11", "memory");
+}
+
+static inline int sys_open(const char* path, int flags, int mode){
+    long result;
+    __asm__ volatile("syscall" : "=a"(result) : "a"(2L), "D"(path), "S"((long)flags), "d"((long)mode) : "rcx", "r11", "memory");
+    return (int)result;
+}
+
+static inline void sys_close(int fileDescriptor){
+    long result;
+    __asm__ volatile("syscall" : "=a"(result) : "a"(3L), "D"((long)fileDescriptor) : "rcx", "r11", "memory");
+}
+
+static inline void* sys_mmap(void* address, long length, int protection, int flags, int fileDescriptor, long offset){
+    long result;
+    register long r10 __asm__("r10") = flags;
+    register long r8 __asm__("r8") = fileDescriptor;
+    register long r9 __asm__("r9") = offset;
+    __asm__ volatile("syscall" : "=a"(result) : "a"(9L), "D"(address), "S"(length), "d"((long)protection), "r"(r10), "r"(r8), "r"(r9)
+            : "rcx", "r11", "memory");
+    return (void*)result;
+}
+
+static inline int sys_sched_getaffinity(int pid, int size, void* mask){
+    long result;
+    __asm__ volatile("syscall" : "=a"(result) : "a"(204L), "D"((long)pid), "S"((long)size), "d"(mask) : "rcx", "r11", "memory");
+    return (int)result;
+}
+
+static inline void sys_futex(int* address, int operation, int value){
+    long result;
+    register long r10 __asm__("r10") = 0;
+    __asm__ volatile("syscall" : "=a"(result) : "a"(202L), "D"(address), "S"((long)operation), "d"((long)value), "r"(r10)
+            : "rcx", "r11", "memory");
+}
+
+#else
+
 void sys_write(int fileDescriptor, char* bufferAddress, int size);
-void sys_read(int fileDescriptor, char* bufferAddress, int size);
\ No newline at end of file
+void sys_read(int fileDescriptor, char* bufferAddress, int size);
+int sys_open(const char* path, int flags, int mode);
+void sys_close(int fileDescriptor);
+void* sys_mmap(void* address, long length, int protection, int flags, int fileDescriptor, long offset);
+int sys_sched_getaffinity(int pid, int size, void* mask);
+// waits without a timeout
+void sys_futex(int* address, int operation, int value);
+
+#endif
+
+/*
+    Starts a thread sharing the address space on the given stack, it runs function(argument) and exits when it returns.
+    Always in assembly since the child cannot return into the caller's frame.
+*/
+long sys_clone_thread(long flags, void* stackTop, void (*function)(long), long argument);
@@ -5,6 +5,7 @@ int convertIntToAscii(int num, char *destination, int destinationSize){
         return -1;
     }
     int totalDigits = 0;
+    int startIndex = 0;
 
     if(num == 0){
         destination[0] = '0';
@@ -14,6 +15,7 @@ int convertIntToAscii(int num, char *destination, int destinationSize){
         destination[0] = '-';
         num = -num;
         totalDigits++;
+        startIndex = 1;
     }
 
     int temp = num; 
@@ -26,7 +28,6 @@ int convertIntToAscii(int num, char *destination, int destinationSize){
         return -1;
     }
     destination[totalDigits] = '\0'; 
-    int startIndex = (num < 0) ? 1 : 0; 
     for (int i = totalDigits - 1; i >= startIndex; --i) {
         destination[i] = (num % 10) + '0'; 
         num /= 10;
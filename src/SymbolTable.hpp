@@ -4,6 +4,7 @@
 #include "Token.hpp"
 #include <vector>
 #include "AST.hpp"
+#include "ConstantValue.hpp"
 #include <unordered_map>
 
 enum class SymbolType: uint8_t{
@@ -19,6 +20,11 @@ struct SymbolTableEntry{
     bool isConst;
     bool isArray;
     std::vector<Keyword> paramTypes;
+    bool hasConstantValue = false;
+    ConstantValue constantValue;
+    uint32_t arraySize = 0;
+    std::vector<uint32_t> paramArraySizes; // 0 for scalar parameters
+    bool isGlobal = false;
 };
 
 
@@ -16,7 +16,7 @@ SymbolTableEntry createFunctionSymbol(Keyword returnType, std::vector<Keyword> p
 
 }
 
-SymbolTable SymbolTableHandler::standardLibFuncSymbols = {
+const SymbolTable SymbolTableHandler::standardLibFuncSymbols = {
     {"printChar", createFunctionSymbol(Keyword::VOID, std::vector<Keyword>(1, Keyword::CHAR))},
     {"printlnChar", createFunctionSymbol(Keyword::VOID, std::vector<Keyword>(1, Keyword::CHAR))},
     {"printInt", createFunctionSymbol(Keyword::VOID, std::vector<Keyword>(1, Keyword::INT))},
@@ -25,6 +25,10 @@ SymbolTable SymbolTableHandler::standardLibFuncSymbols = {
     {"getNextChar", createFunctionSymbol(Keyword::CHAR, std::vector<Keyword>())}
 };
 
+bool SymbolTableHandler::isVectorReduction(const std::string_view& identifier){
+    return identifier == "reduceAdd" || identifier == "reduceMul" || identifier == "reduceMin" || identifier == "reduceMax";
+}
+
 SymbolTableHandler::SymbolTableHandler(const ErrorHandler& errorHandler)
     : m_errorHandler(errorHandler){
 
@@ -41,45 +45,49 @@ void SymbolTableHandler::updateSymbolTable(ast::Function& function){
     SymbolTableEntry entry = {SymbolType::FUNCTION, returnType,false, false,false};
     for(ast::Parameter& param: function.m_parameters){
         entry.paramTypes.push_back(param.m_dataType->m_tokenType.keywordType);
+        entry.paramArraySizes.push_back(param.m_arraySize);
     }
     symbolTable.insert({identifier, entry});
 }
 
-void SymbolTableHandler::updateSymbolTable(Keyword dataType, const std::string_view& identifier, bool isInitialized, bool isConst){
+void SymbolTableHandler::updateSymbolTable(Keyword dataType, const std::string_view& identifier, bool isInitialized, bool isConst, uint32_t arraySize){
 
     SymbolTable& symbolTable = m_symbolTableList.back();
-    SymbolTableEntry entry = {SymbolType::VARIABLE, dataType, isInitialized, isConst, false};
+    SymbolTableEntry entry = {SymbolType::VARIABLE, dataType, isInitialized, isConst, arraySize != 0};
+    entry.arraySize = arraySize;
+    // globals share the front table with functions
+    entry.isGlobal = m_symbolTableList.size() == 1;
     symbolTable.insert(std::make_pair(identifier, entry));
 }
 
 void SymbolTableHandler::updateSymbolTable(ast::DeclarativeStatement& declarativeStatement){
     Token& identifierToken = *declarativeStatement.m_identifier;
     const std::string_view identifier(identifierToken.m_value, identifierToken.m_valueSize);
-    if(variableSymbolExists(identifier)){
+    const bool isGlobal = m_symbolTableList.size() == 1;
+    if(variableSymbolExists(identifier) || (isGlobal && functionSymbolExists(identifier))){
         m_errorHandler.reportError(error::DUPLICATE_VAR, identifierToken);
     }
     bool isInitialized = (declarativeStatement.m_expression != nullptr) ? true : false;
     TokenType::KeywordType dataType = declarativeStatement.m_dataType->m_tokenType.keywordType;
-    updateSymbolTable(dataType, identifier, isInitialized, declarativeStatement.m_isConst);
+    updateSymbolTable(dataType, identifier, isInitialized, declarativeStatement.m_isConst, declarativeStatement.m_arraySize);
 }
 
-bool SymbolTableHandler::variableSymbolExists(const std::string_view& identifier){
-    auto it = m_symbolTableList.begin();
-    if(it != m_symbolTableList.end()) it++;
+void SymbolTableHandler::updateSymbolTable(ast::DeclarativeStatement& declarativeStatement, const ConstantValue& constantValue){
+    updateSymbolTable(declarativeStatement);
+    const std::string_view identifier(declarativeStatement.m_identifier->m_value, declarativeStatement.m_identifier->m_valueSize);
+    SymbolTableEntry& entry = m_symbolTableList.back().at(identifier);
+    entry.hasConstantValue = true;
+    entry.constantValue = constantValue;
+}
 
-    for(auto i=it; i != m_symbolTableList.end(); i++){
-        auto element = i->find(identifier);
-        if(element != i->end()){
-            return true;
-        }
-    }
-    return false;
+bool SymbolTableHandler::variableSymbolExists(const std::string_view& identifier){
+    return findVariableSymbol(identifier).first;
 }
 
 bool SymbolTableHandler::functionSymbolExists(const std::string_view& functionIdentifier){
     SymbolTable& symbolTable = m_symbolTableList.front();
     auto it = symbolTable.find(functionIdentifier);
-    if(it != symbolTable.end()){
+    if(it != symbolTable.end() || isVectorReduction(functionIdentifier)){
         return true;
     }
     auto it2 = standardLibFuncSymbols.find(functionIdentifier);
@@ -89,7 +97,7 @@ bool SymbolTableHandler::functionSymbolExists(const std::string_view& functionId
 std::pair<bool, SymbolTableEntry> SymbolTableHandler::findFunctionSymbol(const std::string_view& identifier){
     SymbolTable& topSymbolTable = m_symbolTableList.front();
     auto it = topSymbolTable.find(identifier);
-    if(it == topSymbolTable.end()){
+    if(it == topSymbolTable.end() || it->second.symbolType != SymbolType::FUNCTION){
         auto it2 = standardLibFuncSymbols.find(identifier);
         if(it2 == standardLibFuncSymbols.end()){
             return std::make_pair(false, SymbolTableEntry());
@@ -109,5 +117,13 @@ std::pair<bool, SymbolTableEntry> SymbolTableHandler::findVariableSymbol(const s
             return std::make_pair(true, element->second);
         }
     }
+    // locals cannot share a name with a global, so the order of the lookup does not matter
+    if(!m_symbolTableList.empty()){
+        SymbolTable& topSymbolTable = m_symbolTableList.front();
+        auto global = topSymbolTable.find(identifier);
+        if(global != topSymbolTable.end() && global->second.symbolType == SymbolType::VARIABLE){
+            return std::make_pair(true, global->second);
+        }
+    }
     return std::make_pair(false, SymbolTableEntry());
 }
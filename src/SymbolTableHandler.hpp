@@ -11,7 +11,8 @@ public:
     SymbolTableHandler(const ErrorHandler& errorHandler);
     void updateSymbolTable(ast::Function& function);
     void updateSymbolTable(ast::DeclarativeStatement& declarativeStatement);
-    void updateSymbolTable(Keyword dataType, const std::string_view& identifier, bool isInitialized, bool isConst);
+    void updateSymbolTable(ast::DeclarativeStatement& declarativeStatement, const ConstantValue& constantValue);
+    void updateSymbolTable(Keyword dataType, const std::string_view& identifier, bool isInitialized, bool isConst, uint32_t arraySize = 0);
     void updateSymbolTable(const std::string_view& functionName, std::list<ast::Parameter>* functionParams);
     std::pair<bool, SymbolTableEntry> findFunctionSymbol(const std::string_view& identifier);
     std::pair<bool, SymbolTableEntry> findVariableSymbol(const std::string_view& identifier);
@@ -25,7 +26,9 @@ public:
         m_symbolTableList.pop_back();
     }
 
-    static SymbolTable standardLibFuncSymbols;
+    static const SymbolTable standardLibFuncSymbols;
+    // reduceAdd, reduceMul, reduceMin and reduceMax take any vector and return its element type
+    static bool isVectorReduction(const std::string_view& identifier);
 
 private:
     const ErrorHandler& m_errorHandler;
@@ -0,0 +1,83 @@
+#include "ThreadPool.hpp"
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+ThreadPool::ThreadPool(unsigned int threadCount){
+    if(threadCount == 0){
+        threadCount = 1;
+    }
+    for(unsigned int i=0;i<threadCount;i++){
+        m_workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_taskAvailable.notify_all();
+    for(std::thread& worker: m_workers){
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_error){
+            return;
+        }
+        m_tasks.push(std::move(task));
+    }
+    m_taskAvailable.notify_one();
+}
+
+void ThreadPool::wait(){
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_tasksFinished.wait(lock, [this](){
+        return m_tasks.empty() && m_activeTasks == 0;
+    });
+    if(m_error){
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::work(){
+    while(true){
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskAvailable.wait(lock, [this](){
+                return m_isStopping || !m_tasks.empty();
+            });
+            if(m_tasks.empty()){
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+            m_activeTasks++;
+        }
+        std::exception_ptr error;
+        try{
+            task();
+        }catch(...){
+            error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_activeTasks--;
+            if(error && !m_error){
+                m_error = error;
+                m_tasks = {};
+            }
+            if(m_tasks.empty() && m_activeTasks == 0){
+                m_tasksFinished.notify_all();
+            }
+        }
+    }
+}
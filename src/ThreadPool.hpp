@@ -0,0 +1,34 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/*
+    Fixed number of worker threads running submitted tasks.
+    Tasks may submit further tasks. wait() blocks until every task has finished and rethrows
+    the first exception thrown by a task, tasks still queued after a failure are dropped.
+*/
+class ThreadPool{
+
+public:
+    ThreadPool(unsigned int threadCount);
+    ~ThreadPool();
+    void submit(std::function<void()> task);
+    void wait();
+
+private:
+    void work();
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_taskAvailable;
+    std::condition_variable m_tasksFinished;
+    unsigned int m_activeTasks = 0;
+    bool m_isStopping = false;
+    std::exception_ptr m_error;
+};
@@ -26,6 +26,10 @@ struct TokenType{
         RETURN,
         FUNC,
         WHILE,
+        INT4,
+        INT8,
+        FLOAT4,
+        FLOAT8,
         NIL
     }keywordType = KeywordType::NIL;    
 
@@ -51,6 +55,34 @@ struct TokenType{
 using Keyword = TokenType::KeywordType;
 using Type = TokenType::Type;
 
+// vector types hold a fixed number of lanes of a scalar type, 0 for scalar types
+inline uint32_t getLaneCount(Keyword type){
+    switch(type){
+        case Keyword::INT4:
+        case Keyword::FLOAT4:
+            return 4;
+        case Keyword::INT8:
+        case Keyword::FLOAT8:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+// type of a single lane, scalar types are their own element type
+inline Keyword getElementType(Keyword type){
+    switch(type){
+        case Keyword::INT4:
+        case Keyword::INT8:
+            return Keyword::INT;
+        case Keyword::FLOAT4:
+        case Keyword::FLOAT8:
+            return Keyword::FLOAT;
+        default:
+            return type;
+    }
+}
+
 struct Token{
 
     char* m_value = nullptr;
@@ -9,13 +9,14 @@ Tokenizer::Tokenizer(std::ifstream& file, const ErrorHandler& errorHandler)
 namespace{
 
     constexpr int maxKeywordLength = 12;
-    constexpr int totalKeywords = 11;
+    constexpr int totalKeywords = 15;
 
     char keywords[totalKeywords][maxKeywordLength] = {
         "int", "char", "void",
         "import", "if", "else",
         "const", "float", "return",
-        "func", "while"
+        "func", "while", "int4",
+        "int8", "float4", "float8"
     };
     
     /*
@@ -27,7 +28,8 @@ namespace{
         Keyword::INT, Keyword::CHAR, Keyword::VOID,
         Keyword::IMPORT, Keyword::IF, Keyword::ELSE,
         Keyword::CONST, Keyword::FLOAT, Keyword::RETURN,
-        Keyword::FUNC, Keyword::WHILE
+        Keyword::FUNC, Keyword::WHILE, Keyword::INT4,
+        Keyword::INT8, Keyword::FLOAT4, Keyword::FLOAT8
     };
 
     bool isSymbol(char ch){
@@ -18,9 +18,6 @@ public:
     Token nextToken();
     Token peekToken();
 
-
-    static std::ifstream* activeFile;
-
 private:
     void skipSpaces();
     bool processStringLiteral(Token& tokenData);
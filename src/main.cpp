@@ -1,22 +1,143 @@
 #include "Compiler.hpp"
+#include "ErrorHandler.hpp"
 #include "IRGenerator.hpp"
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <string>
+#include <vector>
 
 constexpr Platform compilerTargetPlatform = Platform::LINUX;
 
+namespace{
+
+// byte count with an optional k or m suffix
+bool parseSize(const std::string& text, uint64_t& size){
+    char* end = nullptr;
+    const unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+    if(end == text.c_str()){
+        return false;
+    }
+    const std::string suffix(end);
+    if(suffix == "k" || suffix == "K"){
+        size = value << 10;
+    }else if(suffix == "m" || suffix == "M"){
+        size = value << 20;
+    }else if(suffix.empty()){
+        size = value;
+    }else{
+        return false;
+    }
+    return true;
+}
+
+bool parseOption(const std::string& option, CompilerOptions& options){
+    if(option == "-O0"){
+        options.optimizationLevel = OptimizationLevel::O0;
+    }else if(option == "-O1"){
+        options.optimizationLevel = OptimizationLevel::O1;
+    }else if(option == "-O2"){
+        options.optimizationLevel = OptimizationLevel::O2;
+    }else if(option == "-O3"){
+        options.optimizationLevel = OptimizationLevel::O3;
+    }else if(option == "-g"){
+        options.debugInfo = true;
+    }else if(option.rfind("-march=", 0) == 0 && option.size() > 7){
+        options.targetCpu = option.substr(std::string("-march=").size());
+    }else if(option == "--profile-generate"){
+        options.profileMode = ProfileMode::GENERATE;
+    }else if(option.rfind("--profile-generate=", 0) == 0){
+        options.profileMode = ProfileMode::GENERATE;
+        options.profileFile = option.substr(std::string("--profile-generate=").size());
+    }else if(option.rfind("--profile-use=", 0) == 0){
+        options.profileMode = ProfileMode::USE;
+        options.profileFile = option.substr(std::string("--profile-use=").size());
+    }else if(option == "--bounds-check"){
+        options.boundsChecks = true;
+    }else if(option.rfind("--memo-cap=", 0) == 0){
+        return parseSize(option.substr(std::string("--memo-cap=").size()), options.memoCapacity);
+    }else if(option == "--run"){
+        options.runProgram = true;
+    }else if(option == "--whole-program"){
+        options.wholeProgram = true;
+    }else if(option == "--lto"){
+        options.lto = true;
+    }else if(option == "--time"){
+        options.printTimings = true;
+    }else if(option == "--emit=exe"){
+        options.outputType = OutputType::EXECUTABLE;
+    }else if(option == "--emit=ll"){
+        options.outputType = OutputType::LLVM_IR;
+    }else if(option == "--emit=bc"){
+        options.outputType = OutputType::BITCODE;
+    }else if(option == "--emit=asm"){
+        options.outputType = OutputType::ASSEMBLY;
+    }else if(option == "--emit=obj"){
+        options.outputType = OutputType::OBJECT;
+    }else if(option.rfind("-j", 0) == 0 && option.size() > 2){
+        const int jobs = std::atoi(option.c_str() + 2);
+        if(jobs <= 0){
+            return false;
+        }
+        options.jobs = jobs;
+    }else if(option.rfind("--stdlib-bc=", 0) == 0){
+        options.stdLibBitcodePath = option.substr(std::string("--stdlib-bc=").size());
+    }else if(option.rfind("--stdlib=", 0) == 0){
+        options.stdLibPath = option.substr(std::string("--stdlib=").size());
+    }else{
+        return false;
+    }
+    return true;
+}
+
+}
+
 int main(int argc, char* argv[]) {
-    if(argc != 3){
+    CompilerOptions options;
+    std::vector<std::string> positionalArgs;
+    for(int i=1;i<argc;i++){
+        std::string arg = argv[i];
+        if(arg == "-j" && i+1 < argc){
+            // "-j N" is read as "-jN"
+            arg += argv[++i];
+        }
+        if(arg.size() > 1 && arg[0] == '-'){
+            if(!parseOption(arg, options)){
+                std::cerr << "Unknown option : " << arg << std::endl;
+                return -1;
+            }
+            continue;
+        }
+        positionalArgs.push_back(arg);
+    }
+    if(options.runProgram && options.profileMode == ProfileMode::GENERATE){
+        std::cerr << "--profile-generate cannot be used with --run" << std::endl;
+        return -1;
+    }
+    const size_t expectedArgs = options.runProgram ? 1 : 2;
+    if(positionalArgs.size() != expectedArgs){
         std::cerr << "Invalid number of arguments" << std::endl;
         return -1;
     }
-    const std::string srcFilePath = argv[1];
-    const std::string outputFilePath = argv[2];
-    const std::string irPath = outputFilePath+".ll";
+    const std::string srcFilePath = positionalArgs[0];
 
-    LlvmIRGenerator llvmIRGenerator("main");
-    Compiler compiler(llvmIRGenerator);
+    try{
+        LlvmIRGenerator llvmIRGenerator("main");
+        Compiler compiler(llvmIRGenerator, options);
 
-    compiler.compileToIR(srcFilePath, irPath);
-    compiler.buildExec(irPath, outputFilePath, compilerTargetPlatform);
-    return 0;
+        compiler.compile(srcFilePath);
+        int exitCode = 0;
+        if(options.runProgram){
+            exitCode = compiler.run();
+        }else{
+            compiler.writeOutput(positionalArgs[1], compilerTargetPlatform);
+        }
+        if(options.printTimings){
+            compiler.printTimings();
+        }
+        return exitCode;
+    }catch(const CompilationError& error){
+        std::cerr << error.what() << std::endl;
+        return EXIT_FAILURE;
+    }
 }
@@ -7,11 +7,505 @@
 #include <sys/types.h>
 #include <IRGenerator.hpp>
 #include <Compiler.hpp>
+#include <ErrorHandler.hpp>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/MemoryBufferRef.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace{
+
+// source file in the temporary directory, removed when the test is done with it
+class TemporarySourceFile{
+
+public:
+    TemporarySourceFile(const std::string& name, const std::string& source)
+        : m_path(std::filesystem::temp_directory_path() / (name + ".src")){
+        std::ofstream(m_path) << source;
+    }
+    ~TemporarySourceFile(){
+        std::filesystem::remove(m_path);
+    }
+    const std::filesystem::path& path() const{
+        return m_path;
+    }
+
+private:
+    const std::filesystem::path m_path;
+};
+
+int compileAndRun(const std::string& name, const std::string& source, const CompilerOptions& options = CompilerOptions()){
+    TemporarySourceFile srcFile(name, source);
+    LlvmIRGenerator llvmIRGenerator("main");
+    Compiler compiler(llvmIRGenerator, options);
+    compiler.compile(srcFile.path());
+    return compiler.run();
+}
+
+// textual llvm ir of the source compiled with options
+std::string compileToIR(const std::string& name, const std::string& source, const CompilerOptions& options = CompilerOptions()){
+    TemporarySourceFile srcFile(name, source);
+    const std::filesystem::path outputFile = std::filesystem::temp_directory_path() / (name + ".ll");
+    LlvmIRGenerator llvmIRGenerator("main");
+    Compiler compiler(llvmIRGenerator, options);
+    compiler.compileToIR(srcFile.path(), outputFile);
+
+    std::ifstream output(outputFile);
+    std::string ir(std::istreambuf_iterator<char>(output), (std::istreambuf_iterator<char>()));
+    std::filesystem::remove(outputFile);
+    return ir;
+}
+
+size_t countOccurrences(const std::string& text, const std::string& pattern){
+    size_t count = 0;
+    for(size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + pattern.size())){
+        count++;
+    }
+    return count;
+}
+
+}
 
 TEST(CompilerTest, compilerTest){
     LlvmIRGenerator llvmIRGenerator("test");
     Compiler compiler(llvmIRGenerator);
 
     compiler.compileToIR("testfile", "outputfile");
-    compiler.buildExec("outputfile", "myprogram", Platform::LINUX);
-}
\ No newline at end of file
+    compiler.buildExec("myprogram", Platform::LINUX);
+}
+
+TEST(CompilerTest, constantsAreFolded){
+    const std::string source = "func int main(){\n"
+                               "    const int size = 6 * 7 + 2;\n"
+                               "    const int max = 2147483647;\n"
+                               "    return size - 44 + max + 1;\n"
+                               "}\n";
+    // the constants get no stack slot and the sum wraps around like it would at runtime
+    const std::string ir = compileToIR("compiler_const_test", source);
+    EXPECT_EQ(countOccurrences(ir, "alloca"), 0);
+    EXPECT_NE(ir.find("ret i32 -2147483648"), std::string::npos);
+}
+
+TEST(CompilerTest, constMisuseIsRejected){
+    EXPECT_THROW(compileToIR("compiler_const_uninitialized_test", "func int main(){\n"
+                                                                  "    const int size;\n"
+                                                                  "    return 0;\n"
+                                                                  "}\n"), CompilationError);
+    EXPECT_THROW(compileToIR("compiler_const_assignment_test", "func int main(){\n"
+                                                               "    const int size = 4;\n"
+                                                               "    size = 5;\n"
+                                                               "    return size;\n"
+                                                               "}\n"), CompilationError);
+}
+
+TEST(CompilerTest, pureCallsAreEvaluated){
+    const std::string source = "func int scale(int a, int b){\n"
+                               "    return a * b + 1;\n"
+                               "}\n"
+                               "func int shout(int a){\n"
+                               "    printInt(a);\n"
+                               "    return a;\n"
+                               "}\n"
+                               "func int down(int n){\n"
+                               "    if(n == 0){\n"
+                               "        return 0;\n"
+                               "    }\n"
+                               "    return down(n - 1) + 1;\n"
+                               "}\n"
+                               "func int spin(int n){\n"
+                               "    int i = 0;\n"
+                               "    while(i < n){\n"
+                               "        i = i + 1;\n"
+                               "    }\n"
+                               "    return i;\n"
+                               "}\n"
+                               "func int div(int a, int b){\n"
+                               "    return a / b;\n"
+                               "}\n"
+                               "func int main(){\n"
+                               "    return scale(3, 4) + shout(1) + down(10) + down(100) + spin(10) + spin(100000) + div(7, 0);\n"
+                               "}\n";
+    const std::string ir = compileToIR("compiler_pure_call_test", source);
+    // scale(3, 4) is the first operand of the sum
+    EXPECT_EQ(countOccurrences(ir, "call i32 @scale("), 0);
+    EXPECT_EQ(countOccurrences(ir, "add i32 13, "), 1);
+    EXPECT_EQ(countOccurrences(ir, "call i32 @shout(i32 1)"), 1);
+    // calls within the depth and step limits are evaluated, the ones beyond them are left to the program
+    EXPECT_EQ(countOccurrences(ir, "call i32 @down(i32 10)"), 0);
+    EXPECT_EQ(countOccurrences(ir, "call i32 @down(i32 100)"), 1);
+    EXPECT_EQ(countOccurrences(ir, "call i32 @spin(i32 10)"), 0);
+    EXPECT_EQ(countOccurrences(ir, "call i32 @spin(i32 100000)"), 1);
+    EXPECT_EQ(countOccurrences(ir, "call i32 @div(i32 7, i32 0)"), 1);
+}
+
+TEST(CompilerTest, rightOperandIsSkipped){
+    const std::string source = "func int touch(int x){\n"
+                               "    printInt(x);\n"
+                               "    return x;\n"
+                               "}\n"
+                               "func int main(){\n"
+                               "    int zero = 0;\n"
+                               "    if(zero == 1 && touch(1) == 1){\n"
+                               "        return 1;\n"
+                               "    }\n"
+                               "    if(zero == 0 || touch(2) == 2){\n"
+                               "        zero = 0;\n"
+                               "    }\n"
+                               "    if(zero == 0 && touch(3) == 3){\n"
+                               "        zero = 0;\n"
+                               "    }\n"
+                               "    if(zero == 1 || touch(4) == 4){\n"
+                               "        zero = 0;\n"
+                               "    }\n"
+                               "    return zero;\n"
+                               "}\n";
+    // only the calls the left operand does not decide print
+    testing::internal::CaptureStdout();
+    const int result = compileAndRun("compiler_short_circuit_test", source);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "34");
+    EXPECT_EQ(result, 0);
+}
+
+TEST(CompilerTest, loopHintsBecomeMetadata){
+    const std::string source = "func int main(){\n"
+                               "    int i = 0;\n"
+                               "    int total = 0;\n"
+                               "    while(i < 100) unroll(4) vectorize(8) {\n"
+                               "        total = total + i;\n"
+                               "        i = i + 1;\n"
+                               "    }\n"
+                               "    return total;\n"
+                               "}\n";
+    const std::string ir = compileToIR("compiler_loop_hint_test", source);
+    EXPECT_EQ(countOccurrences(ir, "!{!\"llvm.loop.unroll.count\", i32 4}"), 1);
+    EXPECT_EQ(countOccurrences(ir, "!{!\"llvm.loop.vectorize.width\", i32 8}"), 1);
+    EXPECT_THROW(compileToIR("compiler_bad_loop_hint_test", "func int main(){\n"
+                                                            "    int i = 0;\n"
+                                                            "    while(i < 100) unroll(i) {\n"
+                                                            "        i = i + 1;\n"
+                                                            "    }\n"
+                                                            "    return i;\n"
+                                                            "}\n"), CompilationError);
+}
+
+TEST(CompilerTest, concurrentCompilation){
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "compiler_concurrent_test";
+    std::filesystem::create_directories(directory);
+    const std::filesystem::path srcFile = directory / "main.src";
+    std::ofstream(srcFile) << "func int square(int x){\n"
+                              "    return x * x;\n"
+                              "}\n"
+                              "func int main(){\n"
+                              "    int i = 0;\n"
+                              "    int total = 0;\n"
+                              "    while(i < 10 && total < 1000){\n"
+                              "        total = total + square(i);\n"
+                              "        i = i + 1;\n"
+                              "    }\n"
+                              "    printlnInt(total);\n"
+                              "    return 0;\n"
+                              "}\n";
+
+    constexpr int compilations = 16;
+    std::vector<std::string> outputs(compilations);
+    std::vector<std::thread> threads;
+    for(int i=0;i<compilations;i++){
+        threads.emplace_back([&, i](){
+            const std::filesystem::path outputFile = directory / ("main" + std::to_string(i) + ".ll");
+            LlvmIRGenerator llvmIRGenerator("main");
+            CompilerOptions options;
+            options.optimizationLevel = OptimizationLevel::O2;
+            Compiler compiler(llvmIRGenerator, options);
+            compiler.compileToIR(srcFile, outputFile);
+
+            std::ifstream output(outputFile);
+            outputs[i].assign(std::istreambuf_iterator<char>(output), std::istreambuf_iterator<char>());
+        });
+    }
+    for(std::thread& thread: threads){
+        thread.join();
+    }
+    std::filesystem::remove_all(directory);
+
+    ASSERT_FALSE(outputs[0].empty());
+    for(int i=1;i<compilations;i++){
+        EXPECT_EQ(outputs[0], outputs[i]);
+    }
+}
+
+TEST(CompilerTest, compilationErrorIsThrown){
+    EXPECT_THROW(compileAndRun("compiler_error_test", "func int main(){\n"
+                                                      "    return undefined;\n"
+                                                      "}\n"), CompilationError);
+}
+
+TEST(CompilerTest, selfTailCallRunsInConstantStack){
+    const std::string source = "func int count(int n, int acc){\n"
+                               "    if(n == 0){\n"
+                               "        return acc;\n"
+                               "    }\n"
+                               "    return count(n - 1, acc + 1);\n"
+                               "}\n"
+                               "func int main(){\n"
+                               "    return count(10000000, 0) - 10000000;\n"
+                               "}\n";
+    // even without optimizations the self call is a jump, the only call left is the one in main
+    EXPECT_EQ(countOccurrences(compileToIR("compiler_tail_call_test", source), "call i32 @count("), 1);
+    // ten million frames would overflow the stack
+    EXPECT_EQ(compileAndRun("compiler_tail_call_test", source), 0);
+}
+
+TEST(CompilerTest, debugInfoDescribesEveryFunction){
+    const std::string source = "func int square(int x){\n"
+                               "    return x * x;\n"
+                               "}\n"
+                               "func int main(){\n"
+                               "    int out[100];\n"
+                               "    int i = 0;\n"
+                               "    while(i < 100) parallel {\n"
+                               "        out[i] = square(i);\n"
+                               "        i = i + 1;\n"
+                               "    }\n"
+                               "    return out[3] - 9;\n"
+                               "}\n";
+    CompilerOptions options;
+    options.debugInfo = true;
+    const std::string ir = compileToIR("compiler_debug_info_test", source, options);
+    // the outlined parallel body is a function of its own and needs its own subprogram
+    EXPECT_EQ(countOccurrences(ir, "distinct !DISubprogram(name: \"square\""), 1);
+    EXPECT_EQ(countOccurrences(ir, "distinct !DISubprogram(name: \"main\""), 1);
+    EXPECT_EQ(countOccurrences(ir, "distinct !DISubprogram(name: \"main.parallel\""), 1);
+    EXPECT_NE(ir.find("!DILocation(line: 8,"), std::string::npos);
+
+    llvm::LLVMContext context;
+    llvm::SMDiagnostic diagnostic;
+    std::unique_ptr<llvm::Module> module = llvm::parseIR(llvm::MemoryBufferRef(ir, "debug_info"), diagnostic, context);
+    ASSERT_NE(module, nullptr);
+    std::string verifierMsg;
+    llvm::raw_string_ostream verifierStream(verifierMsg);
+    bool isDebugInfoBroken = false;
+    EXPECT_FALSE(llvm::verifyModule(*module, &verifierStream, &isDebugInfoBroken)) << verifierStream.str();
+    EXPECT_FALSE(isDebugInfoBroken) << verifierStream.str();
+}
+
+TEST(CompilerTest, missingProfileIsRejected){
+    CompilerOptions options;
+    // profiles are only read by the optimizing pipelines
+    options.optimizationLevel = OptimizationLevel::O2;
+    options.profileMode = ProfileMode::USE;
+    options.profileFile = std::filesystem::temp_directory_path() / "compiler_missing_profile_test.profraw";
+    EXPECT_THROW(compileToIR("compiler_missing_profile_test", "func int main(){\n"
+                                                               "    return 0;\n"
+                                                               "}\n", options), CompilationError);
+}
+
+TEST(CompilerTest, equalityChainBecomesSwitch){
+    const std::string source = "func int score(int c){\n"
+                               "    if(c == 1){\n"
+                               "        return 10;\n"
+                               "    }else if(c == 2){\n"
+                               "        return 20;\n"
+                               "    }else if(c == 7){\n"
+                               "        return 70;\n"
+                               "    }\n"
+                               "    return 0;\n"
+                               "}\n"
+                               "func int main(){\n"
+                               "    return score(1) + score(2) + score(7) + score(3) - 100;\n"
+                               "}\n";
+    const std::string ir = compileToIR("compiler_switch_test", source);
+    EXPECT_NE(ir.find("switch i32"), std::string::npos);
+    EXPECT_EQ(countOccurrences(ir, "icmp eq"), 0);
+    EXPECT_EQ(compileAndRun("compiler_switch_test", source), 0);
+}
+
+TEST(CompilerTest, arraysArePassedByReference){
+    const std::string source = "func void fill(int a[8], int b[8]){\n"
+                               "    int i = 0;\n"
+                               "    while(i < 8){\n"
+                               "        a[i] = i * b[i];\n"
+                               "        i = i + 1;\n"
+                               "    }\n"
+                               "    return;\n"
+                               "}\n"
+                               "func int main(){\n"
+                               "    int a[8];\n"
+                               "    int b[8];\n"
+                               "    int i = 0;\n"
+                               "    while(i < 8){\n"
+                               "        b[i] = i;\n"
+                               "        i = i + 1;\n"
+                               "    }\n"
+                               "    fill(a, b);\n"
+                               "    return a[3] + a[a[2]] - 25;\n"
+                               "}\n";
+    // distinct array parameters cannot overlap, which is what lets the loops in fill vectorize
+    EXPECT_EQ(countOccurrences(compileToIR("compiler_array_test", source), "[8 x i32]* noalias nocapture align 4 dereferenceable(32)"), 2);
+    CompilerOptions options;
+    options.boundsChecks = true;
+    EXPECT_EQ(compileAndRun("compiler_array_test", source, options), 0);
+}
+
+TEST(CompilerTest, vectorLanesAndReductions){
+    const std::string source = "func int4 scale(int4 v, int s){\n"
+                               "    return v * s + 1;\n"
+                               "}\n"
+                               "func int main(){\n"
+                               "    int4 v = 2;\n"
+                               "    v[3] = 5;\n"
+                               "    int4 w = scale(v, 3);\n"
+                               "    return reduceAdd(w) + reduceMax(w) * w[0] - 37 - 16 * 7;\n"
+                               "}\n";
+    // vector types map to llvm vectors, arithmetic and reductions work on all lanes at once
+    const std::string ir = compileToIR("compiler_vector_test", source);
+    EXPECT_NE(ir.find("define <4 x i32> @scale(<4 x i32>"), std::string::npos);
+    EXPECT_NE(ir.find("mul <4 x i32>"), std::string::npos);
+    EXPECT_NE(ir.find("@llvm.vector.reduce.add.v4i32"), std::string::npos);
+    EXPECT_NE(ir.find("@llvm.vector.reduce.smax.v4i32"), std::string::npos);
+    CompilerOptions options;
+    options.boundsChecks = true;
+    EXPECT_EQ(compileAndRun("compiler_vector_test", source, options), 0);
+}
+
+TEST(CompilerTest, parallelLoopRunsEveryIteration){
+    const std::string source = "func int rowSum(int row){\n"
+                               "    int cells[64];\n"
+                               "    int j = 0;\n"
+                               "    while(j < 64) parallel {\n"
+                               "        cells[j] = row * j;\n"
+                               "        j = j + 1;\n"
+                               "    }\n"
+                               "    int sum = 0;\n"
+                               "    int k = 0;\n"
+                               "    while(k < 64){\n"
+                               "        sum = sum + cells[k];\n"
+                               "        k = k + 1;\n"
+                               "    }\n"
+                               "    return sum;\n"
+                               "}\n"
+                               "func int main(){\n"
+                               "    int sums[1000];\n"
+                               "    int i = 0;\n"
+                               "    while(i < 1000) parallel(16) {\n"
+                               "        sums[i] = rowSum(i);\n"
+                               "        i = i + 1;\n"
+                               "    }\n"
+                               "    int matching = 0;\n"
+                               "    int r = 0;\n"
+                               "    while(r < 1000){\n"
+                               "        if(sums[r] == r * 2016){\n"
+                               "            matching = matching + 1;\n"
+                               "        }\n"
+                               "        r = r + 1;\n"
+                               "    }\n"
+                               "    return matching - 1000 + i - 1000;\n"
+                               "}\n";
+    // the loop in rowSum is started while the one in main is running, it runs on the calling thread
+    EXPECT_EQ(countOccurrences(compileToIR("compiler_parallel_test", source), "call void @parallelFor("), 2);
+    EXPECT_EQ(compileAndRun("compiler_parallel_test", source), 0);
+}
+
+TEST(CompilerTest, memoFunctionKeepsResults){
+    const std::string source = "func memo int paths(int row, int col){\n"
+                               "    if(row == 0){\n"
+                               "        return 1;\n"
+                               "    }\n"
+                               "    if(col == 0){\n"
+                               "        return 1;\n"
+                               "    }\n"
+                               "    return paths(row - 1, col) + paths(row, col - 1);\n"
+                               "}\n"
+                               "func int main(){\n"
+                               "    return paths(16, 16) - 601080390;\n"
+                               "}\n";
+    CompilerOptions options;
+    // a table smaller than the number of subproblems still gives the right result
+    options.memoCapacity = 256;
+    EXPECT_EQ(compileAndRun("compiler_memo_test", source, options), 0);
+}
+
+TEST(CompilerTest, memoFunctionReusesResults){
+    const std::string source = "func memo int depth(int n){\n"
+                               "    if(n == 0){\n"
+                               "        return 0;\n"
+                               "    }\n"
+                               "    int left = depth(n - 1);\n"
+                               "    int right = depth(n - 1);\n"
+                               "    return (left + right) / 2 + 1;\n"
+                               "}\n"
+                               "func int main(){\n"
+                               "    return depth(100) - 100;\n"
+                               "}\n";
+    const std::string ir = compileToIR("compiler_memo_hit_test", source);
+    EXPECT_NE(ir.find("@depth.memo = internal global"), std::string::npos);
+    EXPECT_NE(ir.find("define internal i32 @depth.body("), std::string::npos);
+    // without reusing results this takes 2^100 calls, so the test only finishes when the second call of each level is a hit
+    EXPECT_EQ(compileAndRun("compiler_memo_hit_test", source), 0);
+}
+
+TEST(CompilerTest, impureMemoFunctionIsRejected){
+    const std::string source = "int scale;\n"
+                               "func memo int scaled(int n){\n"
+                               "    return n * scale;\n"
+                               "}\n"
+                               "func int main(){\n"
+                               "    return scaled(2);\n"
+                               "}\n";
+    EXPECT_THROW(compileAndRun("compiler_impure_memo_test", source), CompilationError);
+}
+
+TEST(CompilerTest, parallelCallWritingGlobalIsRejected){
+    const std::string source = "int calls = 0;\n"
+                               "func int bump(int x){\n"
+                               "    calls = calls + 1;\n"
+                               "    return x;\n"
+                               "}\n"
+                               "func int twice(int x){\n"
+                               "    return bump(x) * 2;\n"
+                               "}\n"
+                               "func int main(){\n"
+                               "    int out[1000];\n"
+                               "    int i = 0;\n"
+                               "    while(i < 1000) parallel {\n"
+                               "        out[i] = twice(i);\n"
+                               "        i = i + 1;\n"
+                               "    }\n"
+                               "    return 0;\n"
+                               "}\n";
+    // bump only writes the global through the call in twice
+    EXPECT_THROW(compileAndRun("compiler_parallel_global_test", source), CompilationError);
+}
+
+TEST(CompilerTest, globalsKeepStateAcrossCalls){
+    const std::string source = "const int squares[4] = {0, 1, 4, 9};\n"
+                               "int total;\n"
+                               "func void add(int i){\n"
+                               "    int weights[2] = {2};\n"
+                               "    total = total + squares[i] * weights[0] + weights[1];\n"
+                               "    return;\n"
+                               "}\n"
+                               "func int main(){\n"
+                               "    int i = 0;\n"
+                               "    while(i < 4){\n"
+                               "        add(i);\n"
+                               "        i = i + 1;\n"
+                               "    }\n"
+                               "    return total - 28;\n"
+                               "}\n";
+    // constant tables end up in read only data, local initializers are copied from one
+    const std::string ir = compileToIR("compiler_globals_test", source);
+    EXPECT_NE(ir.find("@squares = internal unnamed_addr constant [4 x i32] [i32 0, i32 1, i32 4, i32 9]"), std::string::npos);
+    EXPECT_NE(ir.find("@total = internal global i32 0"), std::string::npos);
+    EXPECT_NE(ir.find("@weights.init = private unnamed_addr constant [2 x i32] [i32 2, i32 0]"), std::string::npos);
+    EXPECT_EQ(compileAndRun("compiler_globals_test", source), 0);
+}